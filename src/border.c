@@ -18,6 +18,7 @@
 #include "settings.h"
 #include "grab.h"
 #include "button.h"
+#include "move.h"
 
 static char *buttonNames[BI_COUNT];
 static IconNode *buttonIcons[BI_COUNT];
@@ -204,6 +205,7 @@ void ResetBorder(const ClientNode *np)
    int north, south, east, west;
    int width, height;
 
+   InvalidateSnapIndex();
    GrabServer();
 
    /* Determine the size of the window. */
@@ -770,55 +772,86 @@ void ExposeCurrentDesktop(void)
 
 }
 
-/** Get the size of the borders for a client. */
-void GetBorderSize(const ClientState *state,
-                   int *north, int *south, int *east, int *west)
+/** Compute the size of the borders for a client. */
+char ComputeBorderSize(ClientState *state)
 {
 
+   int north, south, east, west;
+
    Assert(state);
-   Assert(north);
-   Assert(south);
-   Assert(east);
-   Assert(west);
 
    /* Full screen is a special case. */
    if(state->status & STAT_FULLSCREEN) {
-      *north = 0;
-      *south = 0;
-      *east = 0;
-      *west = 0;
-      return;
-   }
-
-   if(state->border & BORDER_OUTLINE) {
-
-      *north = settings.borderWidth;
-      *south = settings.borderWidth;
-      *east = settings.borderWidth;
-      *west = settings.borderWidth;
-
+      north = 0;
+      south = 0;
+      east = 0;
+      west = 0;
    } else {
 
-      *north = 0;
-      *south = 0;
-      *east = 0;
-      *west = 0;
+      if(state->border & BORDER_OUTLINE) {
+         north = settings.borderWidth;
+         south = settings.borderWidth;
+         east = settings.borderWidth;
+         west = settings.borderWidth;
+      } else {
+         north = 0;
+         south = 0;
+         east = 0;
+         west = 0;
+      }
 
-   }
+      if(state->border & BORDER_TITLE) {
+         north = settings.titleHeight;
+      }
+      if(state->status & STAT_SHADED) {
+         south = 0;
+      }
+      if(state->maxFlags & MAX_HORIZ) {
+         east = 0;
+         west = 0;
+      }
+      if(state->maxFlags & MAX_VERT) {
+         south = 0;
+      }
 
-   if(state->border & BORDER_TITLE) {
-      *north = settings.titleHeight;
    }
-   if(state->status & STAT_SHADED) {
-      *south = 0;
-   }
-   if(state->maxFlags & MAX_HORIZ) {
-      *east = 0;
-      *west = 0;
+
+   if(   state->north == north && state->south == south
+      && state->east == east && state->west == west) {
+      return 0;
    }
-   if(state->maxFlags & MAX_VERT) {
-      *south = 0;
+   state->north = north;
+   state->south = south;
+   state->east = east;
+   state->west = west;
+   return 1;
+
+}
+
+/** Update the size of the borders for a client. */
+void UpdateBorderSize(ClientNode *np)
+{
+   Assert(np);
+   if(ComputeBorderSize(&np->state)) {
+      WriteFrameExtents(np->window, &np->state);
    }
+}
+
+/** Get the size of the borders for a client. */
+void GetBorderSize(const ClientState *state,
+                   int *north, int *south, int *east, int *west)
+{
+
+   Assert(state);
+   Assert(north);
+   Assert(south);
+   Assert(east);
+   Assert(west);
+
+   *north = state->north;
+   *south = state->south;
+   *east = state->east;
+   *west = state->west;
 
 }
 
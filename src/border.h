@@ -67,7 +67,22 @@ void DrawBorder(const struct ClientNode *np);
  */
 int GetBorderIconSize(void);
 
+/** Compute the size of a window border.
+ * This must be called after the border flags, shading, maximization,
+ * or full screen status of the state change.
+ * @param state The client state.
+ * @return 1 if the border size changed, 0 otherwise.
+ */
+char ComputeBorderSize(struct ClientState *state);
+
+/** Update the size of the border for a client.
+ * This writes _NET_FRAME_EXTENTS if the size changed.
+ * @param np The client.
+ */
+void UpdateBorderSize(struct ClientNode *np);
+
 /** Get the size of a window border.
+ * This returns the size from the last call to ComputeBorderSize.
  * @param state The client state.
  * @param north Pointer to the value to contain the north border size.
  * @param south Pointer to the value to contain the south border size.
@@ -25,6 +25,7 @@
 #include "settings.h"
 #include "timing.h"
 #include "grab.h"
+#include "move.h"
 
 static ClientNode *activeClient;
 
@@ -174,6 +175,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
    LoadIcon(np);
 
    ApplyGroups(np);
+   ComputeBorderSize(&np->state);
 
    /* We now know the layer, so insert */
    np->prev = NULL;
@@ -206,6 +208,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
       JXMapWindow(display, np->window);
       JXMapWindow(display, np->parent);
    }
+   UpdateFreeSpace(np);
 
    clientCount += 1;
 
@@ -225,6 +228,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
    /* Shade the client if requested. */
    if(np->state.status & STAT_SHADED) {
       np->state.status &= ~STAT_SHADED;
+      ComputeBorderSize(&np->state);
       ShadeClient(np);
    }
 
@@ -238,6 +242,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
    if(np->state.maxFlags) {
       const MaxFlags flags = np->state.maxFlags;
       np->state.maxFlags = MAX_NONE;
+      ComputeBorderSize(&np->state);
       MaximizeClient(np, flags);
    }
 
@@ -250,6 +255,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
 
    /* Make sure we're still in sync */
    WriteState(np);
+   WriteFrameExtents(np->window, &np->state);
    SendConfigureEvent(np);
 
    /* Hide the client if we're not on the right desktop. */
@@ -270,6 +276,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
    /* Make the client fullscreen if requested. */
    if(np->state.status & STAT_FULLSCREEN) {
       np->state.status &= ~STAT_FULLSCREEN;
+      UpdateBorderSize(np);
       SetClientFullScreen(np, 1);
    }
    ResetBorder(np);
@@ -295,6 +302,7 @@ void MinimizeTransients(ClientNode *np, char lower)
    int x;
 
    Assert(np);
+   UpdateFreeSpace(np);
 
    /* Unmap the window and update its state. */
    if(np->state.status & (STAT_MAPPED | STAT_SHADED)) {
@@ -302,6 +310,7 @@ void MinimizeTransients(ClientNode *np, char lower)
       JXUnmapWindow(display, np->parent);
    }
    np->state.status |= STAT_MINIMIZED;
+   UpdateTaskBarClient(np);
 
    /* Minimize transient windows. */
    for(x = 0; x < LAYER_COUNT; x++) {
@@ -356,9 +365,11 @@ void ShadeClient(ClientNode *np)
 
    UnmapClient(np);
    np->state.status |= STAT_SHADED;
+   UpdateBorderSize(np);
 
    WriteState(np);
    ResetBorder(np);
+   UpdateFreeSpace(np);
    UpdatePager();
 
 }
@@ -378,9 +389,11 @@ void UnshadeClient(ClientNode *np)
       np->state.status |= STAT_MAPPED;
    }
    np->state.status &= ~STAT_SHADED;
+   UpdateBorderSize(np);
 
    WriteState(np);
    ResetBorder(np);
+   UpdateFreeSpace(np);
    RefocusClient();
    UpdatePager();
 
@@ -391,6 +404,7 @@ void SetClientWithdrawn(ClientNode *np)
 {
 
    Assert(np);
+   UpdateFreeSpace(np);
 
    if(activeClient == np) {
       activeClient = NULL;
@@ -410,6 +424,8 @@ void SetClientWithdrawn(ClientNode *np)
    np->state.status &= ~STAT_SHADED;
    np->state.status &= ~STAT_MINIMIZED;
    np->state.status &= ~STAT_SDESKTOP;
+   UpdateBorderSize(np);
+   UpdateTaskBarClient(np);
 
    WriteState(np);
    UpdateTaskBar();
@@ -425,6 +441,7 @@ void RestoreTransients(ClientNode *np, char raise)
    int x;
 
    Assert(np);
+   UpdateFreeSpace(np);
 
    /* Make sure this window is on the current desktop. */
    SetClientDesktop(np, currentDesktop);
@@ -441,6 +458,7 @@ void RestoreTransients(ClientNode *np, char raise)
    }
    np->state.status &= ~STAT_MINIMIZED;
    np->state.status &= ~STAT_SDESKTOP;
+   UpdateTaskBarClient(np);
 
    /* Restore transient windows. */
    for(x = 0; x < LAYER_COUNT; x++) {
@@ -515,6 +533,7 @@ void SetClientLayer(ClientNode *np, unsigned int layer)
 
                /* Set the new layer */
                tp->state.layer = layer;
+               UpdateFreeSpace(tp);
                WriteState(tp);
 
             }
@@ -555,6 +574,9 @@ void SetClientSticky(ClientNode *np, char isSticky)
                tp->state.status |= STAT_STICKY;
                SetCardinalAtom(tp->window, ATOM_NET_WM_DESKTOP, ~0UL);
                WriteState(tp);
+               UpdateClientStrut(tp);
+               UpdateFreeSpace(tp);
+               UpdateTaskBarClient(tp);
             }
          }
       }
@@ -568,6 +590,7 @@ void SetClientSticky(ClientNode *np, char isSticky)
             if(tp == np || tp->owner == np->window) {
                tp->state.status &= ~STAT_STICKY;
                WriteState(tp);
+               UpdateTaskBarClient(tp);
             }
          }
       }
@@ -601,6 +624,8 @@ void SetClientDesktop(ClientNode *np, unsigned int desktop)
             if(tp == np || tp->owner == np->window) {
 
                tp->state.desktop = desktop;
+               UpdateFreeSpace(tp);
+               UpdateTaskBarClient(tp);
 
                if(desktop == currentDesktop) {
                   ShowClient(tp);
@@ -610,6 +635,7 @@ void SetClientDesktop(ClientNode *np, unsigned int desktop)
 
                SetCardinalAtom(tp->window, ATOM_NET_WM_DESKTOP,
                                tp->state.desktop);
+               UpdateClientStrut(tp);
             }
          }
       }
@@ -685,6 +711,7 @@ void MaximizeClient(ClientNode *np, MaxFlags flags)
       np->width = np->oldWidth;
       np->height = np->oldHeight;
       np->state.maxFlags = MAX_NONE;
+      UpdateBorderSize(np);
    }
    if(flags != MAX_NONE) {
       /* Maximize if requested. */
@@ -693,6 +720,7 @@ void MaximizeClient(ClientNode *np, MaxFlags flags)
 
    WriteState(np);
    ResetBorder(np);
+   UpdateFreeSpace(np);
    DrawBorder(np);
    SendConfigureEvent(np);
    UpdatePager();
@@ -746,6 +774,7 @@ void SetClientFullScreen(ClientNode *np, char fullScreen)
    if(fullScreen) {
 
       np->state.status |= STAT_FULLSCREEN;
+      UpdateBorderSize(np);
 
       if(!(np->state.maxFlags)) {
          np->oldx = np->x;
@@ -768,10 +797,12 @@ void SetClientFullScreen(ClientNode *np, char fullScreen)
       np->width = box.width;
       np->height = box.height;
       ResetBorder(np);
+      UpdateFreeSpace(np);
 
    } else {
 
       np->state.status &= ~STAT_FULLSCREEN;
+      UpdateBorderSize(np);
 
       np->x = np->oldx;
       np->y = np->oldy;
@@ -785,6 +816,7 @@ void SetClientFullScreen(ClientNode *np, char fullScreen)
       }
 
       ResetBorder(np);
+      UpdateFreeSpace(np);
 
       event.type = MapRequest;
       event.xmaprequest.send_event = True;
@@ -816,6 +848,7 @@ void FocusClient(ClientNode *np)
 
       if(activeClient) {
          activeClient->state.status &= ~STAT_ACTIVE;
+         UpdateTaskBarClient(activeClient);
          if(!(activeClient->state.status & STAT_OPACITY)) {
             SetOpacity(activeClient, settings.inactiveClientOpacity, 0);
          }
@@ -823,6 +856,7 @@ void FocusClient(ClientNode *np)
       }
       np->state.status |= STAT_ACTIVE;
       activeClient = np;
+      UpdateTaskBarClient(np);
       if(!(np->state.status & STAT_OPACITY)) {
          SetOpacity(np, settings.activeClientOpacity, 0);
       }
@@ -886,6 +920,8 @@ void KillClientHandler(ClientNode *np)
    JXSync(display, True);
    UngrabServer();
 
+   RemovePagerWindow(np->window, 1);
+
    RemoveClient(np);
 
 }
@@ -1087,6 +1123,8 @@ void RestackClients(void)
       return;
    }
 
+   InvalidateSnapIndex();
+
    /* Allocate memory for restacking. */
    trayCount = GetTrayCount();
    stack = AllocateStack((clientCount + trayCount) * sizeof(Window));
@@ -1172,6 +1210,7 @@ void RemoveClient(ClientNode *np)
    Assert(np);
    Assert(np->window != None);
    Assert(np->parent != None);
+   RemoveFreeSpaceClient(np);
 
    /* Remove this client from the client list */
    if(np->next) {
@@ -1226,6 +1265,9 @@ void RemoveClient(ClientNode *np)
       JXRemoveFromSaveSet(display, np->window);
    }
 
+   /* Release the pager thumbnail while the window still exists. */
+   RemovePagerWindow(np->window, 0);
+
    /* Destroy the parent */
    if(np->parent) {
       JXDestroyWindow(display, np->parent);
@@ -79,6 +79,8 @@ typedef unsigned int StatusFlags;
 #define STAT_NOPAGER    (1 << 21)   /**< Don't show in pager. */
 #define STAT_SHAPED     (1 << 22)   /**< This window is shaped. */
 #define STAT_FLASH      (1 << 23)   /**< Flashing for urgency. */
+#define STAT_SYNC       (1 << 24)   /**< Client uses _NET_WM_SYNC_REQUEST. */
+#define STAT_SMART      (1 << 25)   /**< Use smart window placement. */
 
 /** Maximization flags. */
 typedef unsigned char MaxFlags;
@@ -141,6 +143,7 @@ typedef struct ClientNode {
    char *className;           /**< Name of the window class. */
 
    ClientState state;         /**< Window state. */
+   char hasStruts;            /**< Set if the window has struts. */
 
    BorderActionType borderAction;
 
@@ -10,6 +10,7 @@
 #include "jwm.h"
 #include "confirm.h"
 #include "client.h"
+#include "taskbar.h"
 #include "font.h"
 #include "button.h"
 #include "screen.h"
@@ -314,6 +315,7 @@ void ShowConfirmDialog(ClientNode *np, void (*action)(ClientNode*), ...)
    Assert(dialog->node);
    if(np) {
       dialog->node->owner = np->window;
+      UpdateTaskBarClient(dialog->node);
    }
    dialog->node->state.status |= STAT_WMDIALOG;
    FocusClient(dialog->node);
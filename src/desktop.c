@@ -197,6 +197,7 @@ void ChangeDesktop(unsigned int desktop)
                    showingDesktop[currentDesktop]);
 
    RestackClients();
+   UpdateTaskBarClient(NULL);
    UpdateTaskBar();
 
    LoadBackground(desktop);
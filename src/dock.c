@@ -28,6 +28,9 @@ typedef struct DockNode {
    Window window;
    char needs_reparent;
 
+   int x, y;            /**< Last location set on the window. */
+   int width, height;   /**< Last size set on the window (0 if none). */
+
    struct DockNode *next;
 
 } DockNode;
@@ -289,7 +292,8 @@ char HandleDockResizeRequest(const XResizeRequestEvent *event)
 
    for(np = dock->nodes; np; np = np->next) {
       if(np->window == event->window) {
-         JXResizeWindow(display, np->window, event->width, event->height);
+         /* The size is fixed, but let the window know. */
+         np->width = 0;
          UpdateDock();
          return 1;
       }
@@ -312,6 +316,7 @@ char HandleDockConfigureRequest(const XConfigureRequestEvent *event)
 
    for(np = dock->nodes; np; np = np->next) {
       if(np->window == event->window) {
+         np->width = 0;
          UpdateDock();
          return 1;
       }
@@ -407,6 +412,10 @@ void DockWindow(Window win)
    np = Allocate(sizeof(DockNode));
    np->window = win;
    np->needs_reparent = 0;
+   np->x = 0;
+   np->y = 0;
+   np->width = 0;
+   np->height = 0;
    np->next = dock->nodes;
    dock->nodes = np;
 
@@ -414,7 +423,7 @@ void DockWindow(Window win)
    GetDockSize(&dock->cp->requestedWidth, &dock->cp->requestedHeight);
 
    /* It's safe to reparent at (0, 0) since we call
-    * ResizeTray which will invoke the Resize callback.
+    * UpdateDock which will move the window.
     */
    JXAddToSaveSet(display, win);
    JXSelectInput(display, win,
@@ -424,8 +433,10 @@ void DockWindow(Window win)
    JXReparentWindow(display, win, dock->cp->window, 0, 0);
    JXMapRaised(display, win);
 
-   /* Resize the tray containing the dock. */
+   /* Resize the tray containing the dock.
+    * The dock is updated explicitly in case its size didn't change. */
    ResizeTray(dock->cp->tray);
+   UpdateDock();
 
 }
 
@@ -458,6 +469,7 @@ char UndockWindow(Window win)
 
          /* Resize the tray. */
          ResizeTray(dock->cp->tray);
+         UpdateDock();
 
          return 1;
 
@@ -468,7 +480,9 @@ char UndockWindow(Window win)
    return 0;
 }
 
-/** Layout items on the dock. */
+/** Layout items on the dock.
+ * Only windows that moved or changed size are configured and notified.
+ */
 void UpdateDock(void)
 {
 
@@ -505,24 +519,35 @@ void UpdateDock(void)
          yoffset = 0;
       }
 
-      JXMoveResizeWindow(display, np->window, x + xoffset, y + yoffset,
-                         width, height);
+      if(   np->needs_reparent
+         || np->x != x + xoffset || np->y != y + yoffset
+         || np->width != width || np->height != height) {
 
-      /* Reparent if this window likes to go other places. */
-      if(np->needs_reparent) {
-         JXReparentWindow(display, np->window, dock->cp->window,
-                          x + xoffset, y + yoffset);
-      }
+         np->x = x + xoffset;
+         np->y = y + yoffset;
+         np->width = width;
+         np->height = height;
 
-      event.type = ConfigureNotify;
-      event.event = np->window;
-      event.window = np->window;
-      event.x = x + xoffset;
-      event.y = y + yoffset;
-      event.width = width;
-      event.height = height;
-      JXSendEvent(display, np->window, False, StructureNotifyMask,
-                  (XEvent*)&event);
+         JXMoveResizeWindow(display, np->window, np->x, np->y,
+                            width, height);
+
+         /* Reparent if this window likes to go other places. */
+         if(np->needs_reparent) {
+            JXReparentWindow(display, np->window, dock->cp->window,
+                             np->x, np->y);
+         }
+
+         event.type = ConfigureNotify;
+         event.event = np->window;
+         event.window = np->window;
+         event.x = np->x;
+         event.y = np->y;
+         event.width = width;
+         event.height = height;
+         JXSendEvent(display, np->window, False, StructureNotifyMask,
+                     (XEvent*)&event);
+
+      }
 
       if(orientation == SYSTEM_TRAY_ORIENTATION_HORZ) {
          x += width;
@@ -0,0 +1,292 @@
+/**
+ * @file dynamic.c
+ * @author agent
+ * @date 2026
+ *
+ * @brief Asynchronous dynamic menu generation.
+ *
+ * The output of "exec:" menu includes is read in the background so that
+ * slow menu generators do not block the window manager. The last output
+ * of each command is kept and served while a newer one is generated.
+ *
+ */
+
+#include "jwm.h"
+#include "dynamic.h"
+#include "event.h"
+#include "timing.h"
+#include "error.h"
+#include "main.h"
+#include "misc.h"
+
+/** Time in milliseconds to wait for a command with no output yet. */
+#define DYNAMIC_WAIT_TIME  250
+
+/** Time in milliseconds between reads from running commands. */
+#define DYNAMIC_POLL_TIME  100
+
+/** Initial size of the output buffer. */
+#define DYNAMIC_BLOCK_SIZE 1024
+
+/** Maximum size of the output of a command. */
+#define DYNAMIC_MAX_SIZE   (1 << 24)
+
+/** Structure to represent a dynamic menu command. */
+typedef struct DynamicMenuNode {
+
+   char *command;          /**< The command (including "exec:"). */
+   char *output;           /**< Last complete output (or NULL). */
+   TimeType updated;       /**< Time the output was read. */
+   unsigned int ttl;       /**< Seconds before the output is stale. */
+
+   char *buffer;           /**< Output of the running command. */
+   unsigned int length;    /**< Bytes in buffer. */
+   unsigned int max;       /**< Size of buffer. */
+   int fd;                 /**< Pipe from the running command (or -1). */
+
+   struct DynamicMenuNode *next;
+
+} DynamicMenuNode;
+
+static DynamicMenuNode *dynamicMenus;
+
+static DynamicMenuNode *FindDynamicMenu(const char *command);
+static void StartDynamicMenu(DynamicMenuNode *dp);
+static void WaitDynamicMenu(DynamicMenuNode *dp);
+static char ReadDynamicMenu(DynamicMenuNode *dp);
+static void FinishDynamicMenu(DynamicMenuNode *dp, char success);
+static void SignalDynamicMenu(const TimeType *now, int x, int y, Window w,
+                              void *data);
+
+/** Initialize dynamic menu data. */
+void InitializeDynamicMenus(void)
+{
+   dynamicMenus = NULL;
+}
+
+/** Stop running commands and release dynamic menu data. */
+void DestroyDynamicMenus(void)
+{
+   while(dynamicMenus) {
+      DynamicMenuNode *dp = dynamicMenus->next;
+      if(dynamicMenus->fd >= 0) {
+         FinishDynamicMenu(dynamicMenus, 0);
+      }
+      if(dynamicMenus->output) {
+         Release(dynamicMenus->output);
+      }
+      Release(dynamicMenus->command);
+      Release(dynamicMenus);
+      dynamicMenus = dp;
+   }
+}
+
+/** Set the time to live for a dynamic menu command. */
+void SetDynamicMenuTTL(const char *command, unsigned int ttl)
+{
+   FindDynamicMenu(command)->ttl = ttl;
+}
+
+/** Get the output of a dynamic menu command. */
+const char *GetDynamicMenuOutput(const char *command, char wait)
+{
+
+   DynamicMenuNode *dp;
+
+   Assert(command);
+
+   dp = FindDynamicMenu(command);
+
+   /* Refresh the output in the background if missing or stale. */
+   if(dp->fd < 0) {
+      TimeType now;
+      GetCurrentTime(&now);
+      if(!dp->output || now.seconds < dp->updated.seconds
+         || now.seconds - dp->updated.seconds >= dp->ttl) {
+         StartDynamicMenu(dp);
+      }
+   }
+
+   /* Take output that is already complete. If we don't have any
+    * output yet, give the command a chance if allowed. */
+   if(dp->fd >= 0) {
+      if(wait && !dp->output) {
+         WaitDynamicMenu(dp);
+      } else {
+         ReadDynamicMenu(dp);
+      }
+   }
+
+   return dp->output;
+
+}
+
+/** Find a dynamic menu command, inserting it if not found. */
+DynamicMenuNode *FindDynamicMenu(const char *command)
+{
+
+   DynamicMenuNode *dp;
+
+   for(dp = dynamicMenus; dp; dp = dp->next) {
+      if(!strcmp(dp->command, command)) {
+         return dp;
+      }
+   }
+
+   dp = Allocate(sizeof(DynamicMenuNode));
+   dp->command = CopyString(command);
+   dp->output = NULL;
+   dp->updated.seconds = 0;
+   dp->updated.ms = 0;
+   dp->ttl = 0;
+   dp->buffer = NULL;
+   dp->length = 0;
+   dp->max = 0;
+   dp->fd = -1;
+   dp->next = dynamicMenus;
+   dynamicMenus = dp;
+
+   return dp;
+
+}
+
+/** Start a dynamic menu command in the background. */
+void StartDynamicMenu(DynamicMenuNode *dp)
+{
+
+   char *path;
+   int fds[2];
+   pid_t pid;
+
+   path = CopyString(dp->command + 5);
+   ExpandPath(&path);
+
+   if(JUNLIKELY(pipe(fds) < 0)) {
+      Warning(_("could not execute included program: %s"), path);
+      Release(path);
+      return;
+   }
+
+   pid = fork();
+   if(pid == 0) {
+      close(ConnectionNumber(display));
+      close(fds[0]);
+      if(fds[1] != STDOUT_FILENO) {
+         dup2(fds[1], STDOUT_FILENO);
+         close(fds[1]);
+      }
+      execl(SHELL_NAME, SHELL_NAME, "-c", path, NULL);
+      exit(EXIT_FAILURE);
+   }
+   close(fds[1]);
+
+   if(JUNLIKELY(pid < 0)) {
+      Warning(_("could not execute included program: %s"), path);
+      close(fds[0]);
+      Release(path);
+      return;
+   }
+   Release(path);
+
+   dp->fd = fds[0];
+   dp->length = 0;
+   dp->max = DYNAMIC_BLOCK_SIZE;
+   dp->buffer = Allocate(dp->max + 1);
+   RegisterCallback(DYNAMIC_POLL_TIME, SignalDynamicMenu, dp);
+
+}
+
+/** Wait a short time for a command to finish. */
+void WaitDynamicMenu(DynamicMenuNode *dp)
+{
+
+   TimeType start, now;
+   struct timeval timeout;
+   fd_set fds;
+
+   GetCurrentTime(&start);
+   while(!ReadDynamicMenu(dp)) {
+      unsigned long remaining;
+      GetCurrentTime(&now);
+      remaining = GetTimeDifference(&now, &start);
+      if(remaining >= DYNAMIC_WAIT_TIME) {
+         break;
+      }
+      remaining = DYNAMIC_WAIT_TIME - remaining;
+      FD_ZERO(&fds);
+      FD_SET(dp->fd, &fds);
+      timeout.tv_sec = 0;
+      timeout.tv_usec = remaining * 1000;
+      select(dp->fd + 1, &fds, NULL, NULL, &timeout);
+   }
+
+}
+
+/** Read the available output of a running command.
+ * @return 1 if the command is done, 0 if it is still running.
+ */
+char ReadDynamicMenu(DynamicMenuNode *dp)
+{
+
+   struct timeval timeout;
+   fd_set fds;
+
+   for(;;) {
+
+      int count;
+
+      FD_ZERO(&fds);
+      FD_SET(dp->fd, &fds);
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 0;
+      if(select(dp->fd + 1, &fds, NULL, NULL, &timeout) <= 0) {
+         return 0;
+      }
+
+      if(dp->length == dp->max) {
+         if(JUNLIKELY(dp->max >= DYNAMIC_MAX_SIZE)) {
+            Warning(_("included program output too large: %s"),
+                    dp->command + 5);
+            FinishDynamicMenu(dp, 0);
+            return 1;
+         }
+         dp->max *= 2;
+         dp->buffer = Reallocate(dp->buffer, dp->max + 1);
+      }
+
+      count = read(dp->fd, &dp->buffer[dp->length], dp->max - dp->length);
+      if(count <= 0) {
+         FinishDynamicMenu(dp, count == 0);
+         return 1;
+      }
+      dp->length += count;
+
+   }
+
+}
+
+/** Stop reading a command, saving the output if successful. */
+void FinishDynamicMenu(DynamicMenuNode *dp, char success)
+{
+   UnregisterCallback(SignalDynamicMenu, dp);
+   close(dp->fd);
+   dp->fd = -1;
+   if(success) {
+      dp->buffer[dp->length] = 0;
+      if(dp->output) {
+         Release(dp->output);
+      }
+      dp->output = dp->buffer;
+      GetCurrentTime(&dp->updated);
+   } else {
+      Release(dp->buffer);
+   }
+   dp->buffer = NULL;
+}
+
+/** Callback to read output from a running command. */
+void SignalDynamicMenu(const TimeType *now, int x, int y, Window w,
+                       void *data)
+{
+   ReadDynamicMenu((DynamicMenuNode*)data);
+}
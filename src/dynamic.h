@@ -0,0 +1,38 @@
+/**
+ * @file dynamic.h
+ * @author agent
+ * @date 2026
+ *
+ * @brief Header for asynchronous dynamic menu generation.
+ *
+ */
+
+#ifndef DYNAMIC_H
+#define DYNAMIC_H
+
+/*@{*/
+void InitializeDynamicMenus(void);
+#define StartupDynamicMenus() (void)(0)
+#define ShutdownDynamicMenus() (void)(0)
+void DestroyDynamicMenus(void);
+/*@}*/
+
+/** Set the time to live for the output of a dynamic menu command.
+ * @param command The command (including the "exec:" prefix).
+ * @param ttl The time in seconds before the output should be refreshed.
+ */
+void SetDynamicMenuTTL(const char *command, unsigned int ttl);
+
+/** Get the output of a dynamic menu command.
+ * This returns the last output of the command and starts the command
+ * in the background if the output is missing or stale.
+ * @param command The command (including the "exec:" prefix).
+ * @param wait Set to give a command that has never completed a short
+ *        time to finish. Otherwise only output that is already
+ *        complete is returned.
+ * @return The output (NULL if not available yet). This is only valid
+ *         until the next event is processed.
+ */
+const char *GetDynamicMenuOutput(const char *command, char wait);
+
+#endif /* DYNAMIC_H */
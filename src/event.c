@@ -110,6 +110,11 @@ char WaitForEvent(XEvent *event)
    do {
 
       while(JXPending(display) == 0) {
+
+         /* Update the trays once the pending events have been handled. */
+         FlushTrayDamage();
+         JXFlush(display);
+
          FD_ZERO(&fds);
          FD_SET(fd, &fds);
          timeout.tv_sec = sleepTime / 1000;
@@ -203,6 +208,12 @@ char WaitForEvent(XEvent *event)
          } else if(haveShape && event->type == shapeEvent) {
             HandleShapeEvent((XShapeEvent*)event);
             handled = 1;
+#endif
+#ifdef USE_COMPOSITE
+         } else if(haveComposite
+                   && event->type == damageEvent + XDamageNotify) {
+            HandlePagerDamage((XDamageNotifyEvent*)event);
+            handled = 1;
 #endif
          } else {
             handled = 0;
@@ -236,6 +247,7 @@ void Signal(void)
    static TimeType last = ZERO_TIME;
 
    CallbackNode *cp;   
+   CallbackNode *next;
    TimeType now;
    Window w;
    int x, y;
@@ -246,8 +258,10 @@ void Signal(void)
    }
    last = now;
 
+   /* Note that callbacks are allowed to unregister themselves. */
    GetMousePosition(&x, &y, &w);
-   for(cp = callbacks; cp; cp = cp->next) {
+   for(cp = callbacks; cp; cp = next) {
+      next = cp->next;
       if(cp->freq == 0 || GetTimeDifference(&now, &cp->last) >= cp->freq) {
          cp->last = now;
          (cp->callback)(&now, x, y, w, cp->data);
@@ -293,8 +307,20 @@ void ProcessEvent(XEvent *event)
 void DiscardMotionEvents(XEvent *event, Window w)
 {
    XEvent temp;
-   JXSync(display, False);
-   while(JXCheckTypedEvent(display, MotionNotify, &temp)) {
+
+   /* Pick up any events that have already arrived without waiting
+    * for a round trip to the server. */
+   JXEventsQueued(display, QueuedAfterReading);
+
+   /* Only motion events at the front of the queue are discarded so
+    * that motion is never reordered with respect to other events
+    * (a button release, for example). */
+   while(JXEventsQueued(display, QueuedAlready) > 0) {
+      JXPeekEvent(display, &temp);
+      if(temp.type != MotionNotify) {
+         break;
+      }
+      JXNextEvent(display, &temp);
       UpdateTime(&temp);
       SetMousePosition(temp.xmotion.x_root, temp.xmotion.y_root,
                        temp.xmotion.window);
@@ -307,7 +333,7 @@ void DiscardMotionEvents(XEvent *event, Window w)
 /** Discard key events for the specified window. */
 void DiscardKeyEvents(XEvent *event, Window w)
 {
-   JXSync(display, False);
+   JXEventsQueued(display, QueuedAfterReading);
    while(JXCheckTypedWindowEvent(display, w, KeyPress, event)) {
       UpdateTime(event);
    }
@@ -692,10 +718,13 @@ void HandleConfigureRequest(const XConfigureRequestEvent *event)
          ConstrainSize(np);
          ConstrainPosition(np);
          ResetBorder(np);
+         UpdateFreeSpace(np);
       } else {
          int north, south, east, west;
          GetBorderSize(&np->state, &north, &south, &east, &west);
          JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+         InvalidateSnapIndex();
+         UpdateFreeSpace(np);
       }
 
       SendConfigureEvent(np);
@@ -800,6 +829,7 @@ char HandlePropertyNotify(const XPropertyEvent *event)
          ReadWMNormalHints(np);
          if(ConstrainSize(np)) {
             ResetBorder(np);
+            UpdateFreeSpace(np);
          }
          changed = 1;
          break;
@@ -814,6 +844,8 @@ char HandlePropertyNotify(const XPropertyEvent *event)
          break;
       case XA_WM_TRANSIENT_FOR:
          JXGetTransientForHint(display, np->window, &np->owner);
+         UpdateTaskBarClient(np);
+         changed = 1;
          break;
       case XA_WM_ICON_NAME:
       case XA_WM_CLIENT_MACHINE:
@@ -825,8 +857,7 @@ char HandlePropertyNotify(const XPropertyEvent *event)
          } else if(event->atom == atoms[ATOM_WM_PROTOCOLS]) {
             ReadWMProtocols(np->window, &np->state);
          } else if(event->atom == atoms[ATOM_NET_WM_ICON]) {
-            LoadIcon(np);
-            changed = 1;
+            changed = LoadIcon(np);
          } else if(event->atom == atoms[ATOM_NET_WM_NAME]) {
             ReadWMName(np);
             changed = 1;
@@ -1065,6 +1096,7 @@ void HandleNetMoveResize(const XClientMessageEvent *event, ClientNode *np)
 
    ConstrainSize(np);
    ResetBorder(np);
+   UpdateFreeSpace(np);
    SendConfigureEvent(np);
    UpdatePager();
 
@@ -1210,6 +1242,7 @@ void HandleNetWMState(const XClientMessageEvent *event, ClientNode *np)
       }
       if(actionNolist) {
          np->state.status &= ~STAT_NOLIST;
+         UpdateTaskBarClient(np);
          UpdateTaskBar();
       }
       if(actionNopager) {
@@ -1241,6 +1274,7 @@ void HandleNetWMState(const XClientMessageEvent *event, ClientNode *np)
       }
       if(actionNolist) {
          np->state.status |= STAT_NOLIST;
+         UpdateTaskBarClient(np);
          UpdateTaskBar();
       }
       if(actionNopager) {
@@ -1297,6 +1331,7 @@ void HandleNetWMState(const XClientMessageEvent *event, ClientNode *np)
        * recommendations. */
       if(actionNolist) {
          np->state.status ^= STAT_NOLIST;
+         UpdateTaskBarClient(np);
          UpdateTaskBar();
       }
       if(actionNopager) {
@@ -1404,7 +1439,9 @@ void HandleMapRequest(const XMapEvent *event)
          XMapWindow(display, np->parent);
          if(!(np->state.status & STAT_STICKY)) {
             np->state.desktop = currentDesktop;
+            UpdateClientStrut(np);
          }
+         UpdateTaskBarClient(np);
          if(!(np->state.status & STAT_NOFOCUS)) {
             FocusClient(np);
             RaiseClient(np);
@@ -1445,6 +1482,7 @@ void HandleUnmapNotify(const XUnmapEvent *event)
 
       if(JXCheckTypedWindowEvent(display, np->window, DestroyNotify, &e)) {
          UpdateTime(&e);
+         RemovePagerWindow(np->window, 1);
          RemoveClient(np);
       } else if((np->state.status & STAT_MAPPED) || event->send_event) {
          np->state.status &= ~STAT_MAPPED;
@@ -1469,6 +1507,7 @@ char HandleDestroyNotify(const XDestroyWindowEvent *event)
       if(np->controller) {
          (np->controller)(1);
       }
+      RemovePagerWindow(np->window, 1);
       RemoveClient(np);
       return 1;
    } else {
@@ -1623,6 +1662,7 @@ void UpdateState(ClientNode *np)
    if(np->state.status & STAT_URGENT) {
       RegisterCallback(URGENCY_DELAY, SignalUrgent, np);
    }
+   WriteFrameExtents(np->window, &np->state);
 
    /* We don't handle mapping the window, so restore its mapped state. */
    if(!alreadyMapped) {
@@ -1639,6 +1679,10 @@ void UpdateState(ClientNode *np)
    }
    nodes[np->state.layer] = np;
 
+   UpdateFreeSpace(np);
+   UpdateClientStrut(np);
+   UpdateTaskBarClient(np);
+
 }
 
 /** Update the last event time. */
@@ -310,6 +310,9 @@ void ApplyGroup(const GroupType *gp, ClientNode *np)
       case OPTION_TILED:
          np->state.status |= STAT_TILED;
          break;
+      case OPTION_SMART:
+         np->state.status |= STAT_SMART;
+         break;
       case OPTION_NOTURGENT:
          np->state.status |= STAT_NOTURGENT;
          break;
@@ -47,6 +47,7 @@ typedef unsigned char OptionType;
 #define OPTION_NOMOVE         29    /**< Disallow moving. */
 #define OPTION_NORESIZE       30    /**< Disallow resizing. */
 #define OPTION_NOFULLSCREEN   31    /**< Disallow fullscreen. */
+#define OPTION_SMART          32    /**< Minimum overlap placement. */
 
 /*@{*/
 #define InitializeGroups() (void)(0)
@@ -23,6 +23,9 @@ void DisplayAbout(void)
 void DisplayCompileOptions(void)
 {
    printf("compiled options: "
+#ifdef USE_COMPOSITE
+          "composite "
+#endif
 #ifndef DISABLE_CONFIRM
           "confirm "
 #endif
@@ -64,6 +67,9 @@ void DisplayCompileOptions(void)
 #endif
 #ifdef USE_XRENDER
           "xrender "
+#endif
+#ifdef USE_XSYNC
+          "xsync "
 #endif
           "\nsystem configuration: " SYSTEM_CONFIG "\n");
 }
@@ -136,6 +136,9 @@ static const AtomNode atomList[] = {
    { &atoms[ATOM_NET_WM_ICON_NAME],          "_NET_WM_ICON_NAME"           },
    { &atoms[ATOM_NET_WM_USER_TIME],          "_NET_WM_USER_TIME"           },
    { &atoms[ATOM_NET_WM_USER_TIME_WINDOW],   "_NET_WM_USER_TIME_WINDOW"    },
+   { &atoms[ATOM_NET_WM_SYNC_REQUEST],       "_NET_WM_SYNC_REQUEST"        },
+   { &atoms[ATOM_NET_WM_SYNC_REQUEST_COUNTER],
+      "_NET_WM_SYNC_REQUEST_COUNTER"},
    { &atoms[ATOM_NET_WM_VISIBLE_ICON_NAME],  "_NET_WM_VISIBLE_ICON_NAME"   },
    { &atoms[ATOM_NET_WM_WINDOW_TYPE],        "_NET_WM_WINDOW_TYPE"         },
    { &atoms[ATOM_NET_WM_WINDOW_TYPE_DESKTOP],"_NET_WM_WINDOW_TYPE_DESKTOP" },
@@ -444,8 +447,6 @@ void WriteNetState(ClientNode *np)
                     XA_ATOM, 32, PropModeReplace,
                     (unsigned char*)values, index);
 
-   WriteFrameExtents(np->window, &np->state);
-
 }
 
 /** Set _NET_FRAME_EXTENTS. */
@@ -697,6 +698,12 @@ ClientState ReadWindowState(Window win, char alreadyMapped)
       result.layer = result.defaultLayer;
    }
 
+   result.north = 0;
+   result.south = 0;
+   result.east = 0;
+   result.west = 0;
+   ComputeBorderSize(&result);
+
    /* Check if this window uses the shape extension. */
    if(CheckShape(win)) {
       result.status |= STAT_SHAPED;
@@ -801,6 +808,7 @@ void ReadWMProtocols(Window w, ClientState *state)
 
    state->status &= ~STAT_TAKEFOCUS;
    state->status &= ~STAT_DELETE;
+   state->status &= ~STAT_SYNC;
    status = JXGetWindowProperty(display, w, atoms[ATOM_WM_PROTOCOLS],
                                 0, 32, False, XA_ATOM, &realType, &realFormat,
                                 &count, &extra, &temp);
@@ -814,6 +822,8 @@ void ReadWMProtocols(Window w, ClientState *state)
          state->status |= STAT_DELETE;
       } else if(p[x] == atoms[ATOM_WM_TAKE_FOCUS]) {
          state->status |= STAT_TAKEFOCUS;
+      } else if(p[x] == atoms[ATOM_NET_WM_SYNC_REQUEST]) {
+         state->status |= STAT_SYNC;
       }
    }
 
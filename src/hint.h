@@ -83,6 +83,8 @@ typedef enum {
    ATOM_NET_WM_ICON_NAME,
    ATOM_NET_WM_USER_TIME,
    ATOM_NET_WM_USER_TIME_WINDOW,
+   ATOM_NET_WM_SYNC_REQUEST,
+   ATOM_NET_WM_SYNC_REQUEST_COUNTER,
    ATOM_NET_WM_VISIBLE_ICON_NAME,
    ATOM_NET_WM_WINDOW_TYPE,
    ATOM_NET_WM_WINDOW_TYPE_DESKTOP,
@@ -152,6 +154,10 @@ typedef struct ClientState {
    unsigned char maxFlags;       /**< Maximization status. */
    unsigned char layer;          /**< Current window layer. */
    unsigned char defaultLayer;   /**< Default window layer. */
+   unsigned short north;         /**< Size of the north border. */
+   unsigned short south;         /**< Size of the south border. */
+   unsigned short east;          /**< Size of the east border. */
+   unsigned short west;          /**< Size of the west border. */
 } ClientState;
 
 extern Atom atoms[ATOM_COUNT];
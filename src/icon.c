@@ -34,14 +34,18 @@ typedef struct IconPathNode {
 } IconPathNode;
 
 static IconNode **iconHash;
+static IconNode **binaryHash;
 static IconPathNode *iconPaths;
 static IconPathNode *iconPathsTail;
 static GC iconGC;
 static char iconSizeSet = 0;
+static unsigned int iconSerial = 0;
 
 static void DoDestroyIcon(int index, IconNode *icon);
-static void ReadNetWMIcon(ClientNode *np);
-static void ReadWMHintIcon(ClientNode *np);
+static void ReleaseIcon(IconNode *icon);
+static IconNode *ReadClientIcon(ClientNode *np);
+static IconNode *ReadNetWMIcon(ClientNode *np);
+static IconNode *ReadWMHintIcon(ClientNode *np);
 static IconNode *CreateIcon(void);
 static IconNode *GetDefaultIcon(void);
 static IconNode *CreateIconFromData(const char *name, char **data);
@@ -66,6 +70,14 @@ static void InsertIcon(IconNode *icon);
 static IconNode *FindIcon(const char *name);
 static unsigned int GetHash(const char *str);
 
+static IconNode *FindBinaryIcon(unsigned int hash, unsigned int digest,
+                                unsigned int length);
+static void InsertBinaryIcon(IconNode *icon);
+static void RemoveBinaryIcon(IconNode *icon);
+static unsigned int GetContentHash(unsigned int hash, unsigned long value);
+static unsigned int GetContentDigest(unsigned int digest,
+                                     unsigned long value);
+
 /** Initialize icon data.
  * This must be initialized before parsing the configuration.
  */
@@ -75,8 +87,10 @@ void InitializeIcons(void)
    iconPaths = NULL;
    iconPathsTail = NULL;
    iconHash = Allocate(sizeof(IconNode*) * HASH_SIZE);
+   binaryHash = Allocate(sizeof(IconNode*) * HASH_SIZE);
    for(x = 0; x < HASH_SIZE; x++) {
       iconHash[x] = NULL;
+      binaryHash[x] = NULL;
    }
    memset(&emptyIcon, 0, sizeof(emptyIcon));
    iconSizeSet = 0;
@@ -109,6 +123,11 @@ void ShutdownIcons(void)
       while(iconHash[x]) {
          DoDestroyIcon(x, iconHash[x]);
       }
+      while(binaryHash[x]) {
+         IconNode *icon = binaryHash[x];
+         RemoveBinaryIcon(icon);
+         ReleaseIcon(icon);
+      }
    }
    JXFreeGC(display, iconGC);
 }
@@ -128,6 +147,10 @@ void DestroyIcons(void)
       Release(iconHash);
       iconHash = NULL;
    }
+   if(binaryHash) {
+      Release(binaryHash);
+      binaryHash = NULL;
+   }
 }
 
 /** Add an icon search path. */
@@ -225,27 +248,43 @@ void PutIcon(const VisualData *visual, IconNode *icon, Drawable d, long fg,
 }
 
 /** Load the icon for a client. */
-void LoadIcon(ClientNode *np)
+char LoadIcon(ClientNode *np)
 {
 
-   IconPathNode *ip;
+   IconNode *oldIcon;
+   char changed;
 
    Assert(np);
 
-   /* If client already has an icon, destroy it first. */
-   DestroyIcon(np->icon);
-   np->icon = NULL;
+   /* Keep the old icon until the new one is loaded.
+    * If the icon data did not change, this will get us another
+    * reference to the same shared icon. */
+   oldIcon = np->icon;
+   np->icon = ReadClientIcon(np);
+   changed = np->icon != oldIcon;
+   DestroyIcon(oldIcon);
+
+   return changed;
+
+}
+
+/** Read the icon for a client. */
+IconNode *ReadClientIcon(ClientNode *np)
+{
+
+   IconPathNode *ip;
+   IconNode *icon;
 
    /* Attempt to read _NET_WM_ICON for an icon. */
-   ReadNetWMIcon(np);
-   if(np->icon) {
-      return;
+   icon = ReadNetWMIcon(np);
+   if(icon) {
+      return icon;
    }
 
    /* Attempt to read an icon from XWMHints. */
-   ReadWMHintIcon(np);
-   if(np->icon) {
-      return;
+   icon = ReadWMHintIcon(np);
+   if(icon) {
+      return icon;
    }
 
    /* Attempt to find an icon for this program in the icon directory */
@@ -253,30 +292,30 @@ void LoadIcon(ClientNode *np)
       for(ip = iconPaths; ip; ip = ip->next) {
 
 #ifdef USE_PNG
-         np->icon = LoadSuffixedIcon(ip->path, np->instanceName, ".png");
-         if(np->icon) {
-            return;
+         icon = LoadSuffixedIcon(ip->path, np->instanceName, ".png");
+         if(icon) {
+            return icon;
          }
 #endif
 
 #ifdef USE_XPM
-         np->icon = LoadSuffixedIcon(ip->path, np->instanceName, ".xpm");
-         if(np->icon) {
-            return;
+         icon = LoadSuffixedIcon(ip->path, np->instanceName, ".xpm");
+         if(icon) {
+            return icon;
          }
 #endif
 
 #ifdef USE_JPEG
-         np->icon = LoadSuffixedIcon(ip->path, np->instanceName, ".jpg");
-         if(np->icon) {
-            return;
+         icon = LoadSuffixedIcon(ip->path, np->instanceName, ".jpg");
+         if(icon) {
+            return icon;
          }
 #endif
 
 #ifdef USE_ICONS
-         np->icon = LoadSuffixedIcon(ip->path, np->instanceName, ".xbm");
-         if(np->icon) {
-            return;
+         icon = LoadSuffixedIcon(ip->path, np->instanceName, ".xbm");
+         if(icon) {
+            return icon;
          }
 #endif
 
@@ -284,7 +323,7 @@ void LoadIcon(ClientNode *np)
    }
 
    /* Load the default icon */
-   np->icon = GetDefaultIcon();
+   return GetDefaultIcon();
 
 }
 
@@ -372,7 +411,7 @@ IconNode *LoadNamedIconHelper(const char *name, const char *path,
 }
 
 /** Read the icon property from a client. */
-void ReadNetWMIcon(ClientNode *np)
+IconNode *ReadNetWMIcon(ClientNode *np)
 {
    static const long MAX_LENGTH = 1 << 20;
    unsigned long count;
@@ -381,19 +420,22 @@ void ReadNetWMIcon(ClientNode *np)
    Atom realType;
    int realFormat;
    unsigned char *data;
+   IconNode *icon = NULL;
    status = JXGetWindowProperty(display, np->window, atoms[ATOM_NET_WM_ICON],
                                 0, MAX_LENGTH, False, XA_CARDINAL,
                                 &realType, &realFormat, &count, &extra, &data);
    if(status == Success && realFormat != 0 && data) {
-      np->icon = CreateIconFromBinary((unsigned long*)data, count);
+      icon = CreateIconFromBinary((unsigned long*)data, count);
       JXFree(data);
    }
+   return icon;
 }
 
 /** Read the icon WMHint property from a client. */
-void ReadWMHintIcon(ClientNode *np)
+IconNode *ReadWMHintIcon(ClientNode *np)
 {
    XWMHints *hints;
+   IconNode *icon = NULL;
    hints = JXGetWMHints(display, np->window);
    if(hints) {
       Drawable d = None;
@@ -405,10 +447,11 @@ void ReadWMHintIcon(ClientNode *np)
          d = hints->icon_pixmap;
       }
       if(d != None) {
-         np->icon = CreateIconFromDrawable(d, mask);
+         icon = CreateIconFromDrawable(d, mask);
       }
       JXFree(hints);
    }
+   return icon;
 }
 
 /** Create the default icon. */
@@ -446,18 +489,50 @@ IconNode *CreateIconFromData(const char *name, char **data)
 
 }
 
+/** Create an icon from a pixmap and mask (as specified via WMHints). */
 IconNode *CreateIconFromDrawable(Drawable d, Pixmap mask)
 {
    ImageNode *image;
+   IconNode *result;
+   unsigned int hash, digest;
+   unsigned int length;
+   unsigned int x;
 
    image = LoadImageFromDrawable(d, mask);
-   if(image) {
-      IconNode *result = CreateIcon();
-      result->images = image;
-      return result;
-   } else {
+   if(!image) {
       return NULL;
    }
+
+   /* Hash the image as _NET_WM_ICON data so that identical icons
+    * are shared regardless of their source. */
+   length = image->width * image->height + 2;
+   hash = GetContentHash(0, image->width);
+   hash = GetContentHash(hash, image->height);
+   digest = GetContentDigest(0, image->width);
+   digest = GetContentDigest(digest, image->height);
+   for(x = 2; x < length; x++) {
+      const unsigned char *p = &image->data[(x - 2) * 4];
+      const unsigned long value = ((unsigned long)p[0] << 24)
+                                | ((unsigned long)p[1] << 16)
+                                | ((unsigned long)p[2] << 8)
+                                | (unsigned long)p[3];
+      hash = GetContentHash(hash, value);
+      digest = GetContentDigest(digest, value);
+   }
+
+   result = FindBinaryIcon(hash, digest, length);
+   if(result) {
+      DestroyImage(image);
+      return result;
+   }
+
+   result = CreateIcon();
+   result->images = image;
+   result->hash = hash;
+   result->digest = digest;
+   result->length = length;
+   InsertBinaryIcon(result);
+   return result;
 }
 
 /** Create an icon from the specified file. */
@@ -699,11 +774,26 @@ IconNode *CreateIconFromBinary(const unsigned long *input,
 {
    IconNode *result = NULL;
    unsigned int offset = 0;
+   unsigned int hash, digest;
+   unsigned int x;
 
    if(!input) {
       return NULL;
    }
 
+   /* Hash the data first so that we can skip decoding icons we
+    * already have. */
+   hash = 0;
+   digest = 0;
+   for(x = 0; x < length; x++) {
+      hash = GetContentHash(hash, input[x]);
+      digest = GetContentDigest(digest, input[x]);
+   }
+   result = FindBinaryIcon(hash, digest, length);
+   if(result) {
+      return result;
+   }
+
    while(offset < length) {
 
       const unsigned int width = input[offset + 0];
@@ -715,10 +805,10 @@ IconNode *CreateIconFromBinary(const unsigned long *input,
       if(JUNLIKELY(width * height + 2 > length - offset)) {
          Debug("invalid image size: %d x %d + 2 > %d",
                width, height, length - offset);
-         return result;
+         break;
       } else if(JUNLIKELY(width == 0 || height == 0)) {
          Debug("invalid image size: %d x %d", width, height);
-         return result;
+         break;
       }
 
       if(result == NULL) {
@@ -742,8 +832,14 @@ IconNode *CreateIconFromBinary(const unsigned long *input,
       /* Move to the next size. */
       offset += 2 + width * height;
 
-      /* Don't insert this icon into the hash since it is transient. */
+   }
 
+   /* Share this icon with other clients using the same data. */
+   if(result) {
+      result->hash = hash;
+      result->digest = digest;
+      result->length = length;
+      InsertBinaryIcon(result);
    }
 
    return result;
@@ -758,6 +854,12 @@ IconNode *CreateIcon(void)
    icon->images = NULL;
    icon->next = NULL;
    icon->prev = NULL;
+   icon->hash = 0;
+   icon->digest = 0;
+   icon->length = 0;
+   icon->refCount = 0;
+   iconSerial += 1;
+   icon->serial = iconSerial;
    icon->preserveAspect = 1;
    return icon;
 }
@@ -766,37 +868,6 @@ IconNode *CreateIcon(void)
 void DoDestroyIcon(int index, IconNode *icon)
 {
    if(icon) {
-      ImageNode *image = icon->images;
-      while(image) {
-         ScaledIconNode *np = image->nodes;
-         while(np) {
-            ScaledIconNode *next_node = np->next;
-
-#ifdef USE_XRENDER
-            if(np->imagePicture != None) {
-               JXRenderFreePicture(display, np->imagePicture);
-            }
-            if(np->alphaPicture != None) {
-               JXRenderFreePicture(display, np->alphaPicture);
-            }
-#endif
-            if(np->image != None) {
-               JXFreePixmap(display, np->image);
-            }
-            if(np->mask != None) {
-               JXFreePixmap(display, np->mask);
-            }
-
-            Release(np);
-            np = next_node;
-         }
-         image = image->next;
-      }
-      if(icon->name) {
-         Release(icon->name);
-      }
-      DestroyImage(icon->images);
-
       if(icon->prev) {
          icon->prev->next = icon->next;
       } else {
@@ -805,16 +876,58 @@ void DoDestroyIcon(int index, IconNode *icon)
       if(icon->next) {
          icon->next->prev = icon->prev;
       }
-      Release(icon);
+      ReleaseIcon(icon);
+   }
+}
+
+/** Release the resources used by an icon. */
+void ReleaseIcon(IconNode *icon)
+{
+   ImageNode *image = icon->images;
+   while(image) {
+      ScaledIconNode *np = image->nodes;
+      while(np) {
+         ScaledIconNode *next_node = np->next;
+
+#ifdef USE_XRENDER
+         if(np->imagePicture != None) {
+            JXRenderFreePicture(display, np->imagePicture);
+         }
+         if(np->alphaPicture != None) {
+            JXRenderFreePicture(display, np->alphaPicture);
+         }
+#endif
+         if(np->image != None) {
+            JXFreePixmap(display, np->image);
+         }
+         if(np->mask != None) {
+            JXFreePixmap(display, np->mask);
+         }
+
+         Release(np);
+         np = next_node;
+      }
+      image = image->next;
    }
+   if(icon->name) {
+      Release(icon->name);
+   }
+   DestroyImage(icon->images);
+   Release(icon);
 }
 
 /** Destroy an icon. */
 void DestroyIcon(IconNode *icon)
 {
    if(icon && !icon->name) {
-      const unsigned int index = GetHash(icon->name);
-      DoDestroyIcon(index, icon);
+      if(icon->refCount > 0) {
+         icon->refCount -= 1;
+         if(icon->refCount > 0) {
+            return;
+         }
+         RemoveBinaryIcon(icon);
+      }
+      ReleaseIcon(icon);
    }
 }
 
@@ -862,5 +975,78 @@ unsigned int GetHash(const char *str)
    return hash;
 }
 
+/** Find a shared icon with the specified content.
+ * Icons are matched on two independent hashes of the content and its
+ * length so that the content itself need not be kept.
+ * This returns a new reference to the icon.
+ */
+IconNode *FindBinaryIcon(unsigned int hash, unsigned int digest,
+                         unsigned int length)
+{
+   IconNode *icon = binaryHash[hash & (HASH_SIZE - 1)];
+   while(icon) {
+      if(   icon->hash == hash && icon->digest == digest
+         && icon->length == length) {
+         icon->refCount += 1;
+         return icon;
+      }
+      icon = icon->next;
+   }
+   return NULL;
+}
+
+/** Insert a shared icon to the binary icon hash table. */
+void InsertBinaryIcon(IconNode *icon)
+{
+   const unsigned int index = icon->hash & (HASH_SIZE - 1);
+   Assert(!icon->name);
+   icon->refCount = 1;
+   icon->prev = NULL;
+   if(binaryHash[index]) {
+      binaryHash[index]->prev = icon;
+   }
+   icon->next = binaryHash[index];
+   binaryHash[index] = icon;
+}
+
+/** Remove a shared icon from the binary icon hash table. */
+void RemoveBinaryIcon(IconNode *icon)
+{
+   if(icon->prev) {
+      icon->prev->next = icon->next;
+   } else {
+      binaryHash[icon->hash & (HASH_SIZE - 1)] = icon->next;
+   }
+   if(icon->next) {
+      icon->next->prev = icon->prev;
+   }
+}
+
+/** Add a 32-bit value to a content digest (MurmurHash3 mixing). */
+unsigned int GetContentDigest(unsigned int digest, unsigned long value)
+{
+   unsigned int k = (unsigned int)(value & 0xFFFFFFFFUL);
+   k *= 0xCC9E2D51U;
+   k = (k << 15) | (k >> 17);
+   k *= 0x1B873593U;
+   digest ^= k;
+   digest = (digest << 13) | (digest >> 19);
+   return digest * 5 + 0xE6546B64U;
+}
+
+/** Add a 32-bit value to a content hash (FNV-1a). */
+unsigned int GetContentHash(unsigned int hash, unsigned long value)
+{
+   unsigned int x;
+   if(hash == 0) {
+      hash = 2166136261U;
+   }
+   for(x = 0; x < 32; x += 8) {
+      hash ^= (value >> x) & 0xFF;
+      hash *= 16777619U;
+   }
+   return hash;
+}
+
 #endif /* USE_ICONS */
 
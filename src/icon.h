@@ -40,6 +40,13 @@ typedef struct IconNode {
    struct IconNode *next;         /**< The next icon in the list. */
    struct IconNode *prev;         /**< The previous icon in the list. */
 
+   unsigned int hash;             /**< Content hash (binary icons). */
+   unsigned int digest;           /**< Second content hash. */
+   unsigned int length;           /**< Length of the hashed content. */
+   unsigned int refCount;         /**< References to a shared binary icon.
+                                   *   Zero if the icon is not shared. */
+   unsigned int serial;           /**< Unique for each icon created. */
+
    char preserveAspect;           /**< Set to preserve the aspect ratio
                                    *   of the icon when scaling. */
 
@@ -78,9 +85,12 @@ void PutIcon(const struct VisualData *visual, IconNode *icon, Drawable d,
              long fg, int x, int y, int width, int height);
 
 /** Load an icon for a client.
+ * Icons read from the client are shared between clients with identical
+ * icon data. If the data has not changed, the current icon is kept.
  * @param np The client.
+ * @return 1 if the icon changed, 0 otherwise.
  */
-void LoadIcon(struct ClientNode *np);
+char LoadIcon(struct ClientNode *np);
 
 /** Load an icon.
  * @param name The name of the icon to load.
@@ -91,6 +101,7 @@ void LoadIcon(struct ClientNode *np);
 IconNode *LoadNamedIcon(const char *name, char save, char preserveAspect);
 
 /** Destroy an icon.
+ * Shared icons are only destroyed when the last reference is released.
  * @param icon The icon to destroy.
  */
 void DestroyIcon(IconNode *icon);
@@ -105,7 +116,7 @@ void DestroyIcon(IconNode *icon);
 #define DestroyIcons()                     ICON_DUMMY_FUNCTION
 #define AddIconPath( a )                   ICON_DUMMY_FUNCTION
 #define PutIcon( a, b, c, d, e, f, g, h )  ICON_DUMMY_FUNCTION
-#define LoadIcon( a )                      ICON_DUMMY_FUNCTION
+#define LoadIcon( a )                      0
 #define LoadNamedIcon( a, b, c )           NULL
 #define DestroyIcon( a )                   ICON_DUMMY_FUNCTION
 
@@ -83,6 +83,9 @@
 #  ifdef USE_SHAPE
 #     include <X11/extensions/shape.h>
 #  endif
+#  ifdef USE_XSYNC
+#     include <X11/extensions/sync.h>
+#  endif
 
 #  ifdef USE_XMU
 #     include <X11/Xmu/Xmu.h>
@@ -100,6 +103,10 @@
 #  ifdef USE_XRENDER
 #     include <X11/extensions/Xrender.h>
 #  endif
+#  ifdef USE_COMPOSITE
+#     include <X11/extensions/Xcomposite.h>
+#     include <X11/extensions/Xdamage.h>
+#  endif
 #  ifdef USE_FRIBIDI
 #     include <fribidi/fribidi.h>
 #  endif
@@ -269,6 +269,12 @@
 #define JXPending( a ) \
    ( SetCheckpoint(), XPending( a ) )
 
+#define JXEventsQueued( a, b ) \
+   ( SetCheckpoint(), XEventsQueued( a, b ) )
+
+#define JXPeekEvent( a, b ) \
+   ( SetCheckpoint(), XPeekEvent( a, b ) )
+
 #define JXPutBackEvent( a, b ) \
    ( SetCheckpoint(), XPutBackEvent( a, b ) )
 
@@ -366,6 +372,24 @@
 #define JXShapeSelectInput( a, b, c ) \
    ( SetCheckpoint(), XShapeSelectInput( a, b, c ) )
 
+#define JXSyncQueryExtension( a, b, c ) \
+   ( SetCheckpoint(), XSyncQueryExtension( a, b, c ) )
+
+#define JXSyncInitialize( a, b, c ) \
+   ( SetCheckpoint(), XSyncInitialize( a, b, c ) )
+
+#define JXSyncQueryCounter( a, b, c ) \
+   ( SetCheckpoint(), XSyncQueryCounter( a, b, c ) )
+
+#define JXSyncCreateAlarm( a, b, c ) \
+   ( SetCheckpoint(), XSyncCreateAlarm( a, b, c ) )
+
+#define JXSyncChangeAlarm( a, b, c, d ) \
+   ( SetCheckpoint(), XSyncChangeAlarm( a, b, c, d ) )
+
+#define JXSyncDestroyAlarm( a, b ) \
+   ( SetCheckpoint(), XSyncDestroyAlarm( a, b ) )
+
 #define JXStoreName( a, b, c ) \
    ( SetCheckpoint(), XStoreName( a, b, c ) )
 
@@ -470,5 +494,36 @@
    ( SetCheckpoint(), \
      XRenderComposite( a, b, c, d, e, f, g, h, i, j, k, l, m) )
 
+#define JXRenderSetPictureTransform( a, b, c ) \
+   ( SetCheckpoint(), XRenderSetPictureTransform( a, b, c ) )
+
+#define JXRenderSetPictureFilter( a, b, c, d, e ) \
+   ( SetCheckpoint(), XRenderSetPictureFilter( a, b, c, d, e ) )
+
+/* Composite */
+
+#define JXCompositeQueryExtension( a, b, c ) \
+   ( SetCheckpoint(), XCompositeQueryExtension( a, b, c ) )
+
+#define JXCompositeRedirectSubwindows( a, b, c ) \
+   ( SetCheckpoint(), XCompositeRedirectSubwindows( a, b, c ) )
+
+#define JXCompositeUnredirectSubwindows( a, b, c ) \
+   ( SetCheckpoint(), XCompositeUnredirectSubwindows( a, b, c ) )
+
+/* Damage */
+
+#define JXDamageQueryExtension( a, b, c ) \
+   ( SetCheckpoint(), XDamageQueryExtension( a, b, c ) )
+
+#define JXDamageCreate( a, b, c ) \
+   ( SetCheckpoint(), XDamageCreate( a, b, c ) )
+
+#define JXDamageDestroy( a, b ) \
+   ( SetCheckpoint(), XDamageDestroy( a, b ) )
+
+#define JXDamageSubtract( a, b, c, d ) \
+   ( SetCheckpoint(), XDamageSubtract( a, b, c, d ) )
+
 #endif /* JXLIB_H */
 
@@ -28,6 +28,8 @@
 #include "tray.h"
 #include "traybutton.h"
 #include "popup.h"
+#include "outline.h"
+#include "status.h"
 #include "pager.h"
 #include "swallow.h"
 #include "screen.h"
@@ -36,6 +38,7 @@
 #include "place.h"
 #include "clock.h"
 #include "dock.h"
+#include "dynamic.h"
 #include "misc.h"
 #include "background.h"
 #include "settings.h"
@@ -70,9 +73,17 @@ XContext frameContext;
 char haveShape;
 int shapeEvent;
 #endif
+#ifdef USE_XSYNC
+char haveSync;
+int syncEvent;
+#endif
 #ifdef USE_XRENDER
 char haveRender;
 #endif
+#ifdef USE_COMPOSITE
+char haveComposite;
+int damageEvent;
+#endif
 
 static const char *CONFIG_FILE = "/.jwmrc";
 
@@ -324,9 +335,18 @@ void StartupConnection(void)
 #ifdef USE_SHAPE
    int shapeError;
 #endif
+#ifdef USE_XSYNC
+   int syncError;
+   int syncMajor, syncMinor;
+#endif
 #ifdef USE_XRENDER
    int renderEvent;
    int renderError;
+#endif
+#ifdef USE_COMPOSITE
+   int compositeEvent;
+   int compositeError;
+   int damageError;
 #endif
    struct sigaction sa;
    char name[32];
@@ -420,6 +440,16 @@ void StartupConnection(void)
    }
 #endif
 
+#ifdef USE_XSYNC
+   haveSync = JXSyncQueryExtension(display, &syncEvent, &syncError)
+           && JXSyncInitialize(display, &syncMajor, &syncMinor);
+   if(haveSync) {
+      Debug("sync extension enabled");
+   } else {
+      Debug("sync extension disabled");
+   }
+#endif
+
 #ifdef USE_XRENDER
    haveRender = JXRenderQueryExtension(display, &renderEvent, &renderError);
    if(haveRender) {
@@ -429,6 +459,17 @@ void StartupConnection(void)
    }
 #endif
 
+#ifdef USE_COMPOSITE
+   haveComposite = haveRender
+      && JXCompositeQueryExtension(display, &compositeEvent, &compositeError)
+      && JXDamageQueryExtension(display, &damageEvent, &damageError);
+   if(haveComposite) {
+      Debug("composite extension enabled");
+   } else {
+      Debug("composite extension disabled");
+   }
+#endif
+
    /* Make sure we have input focus. */
    win = None;
    JXGetInputFocus(display, &win, &revert);
@@ -477,17 +518,20 @@ void Initialize(void)
    InitializeDialogs();
 #endif
    InitializeDock();
+   InitializeDynamicMenus();
    InitializeFonts();
    InitializeGroups();
    InitializeHints();
    InitializeIcons();
    InitializeKeys();
+   InitializeOutline();
    InitializePager();
    InitializePlacement();
    InitializePopup();
    InitializeRootMenu();
    InitializeScreens();
    InitializeSettings();
+   InitializeStatus();
    InitializeSwallow();
    InitializeTaskBar();
    InitializeTray();
@@ -533,6 +577,8 @@ void Startup(void)
       StartupDialogs();
 #  endif
    StartupPopup();
+   StartupOutline();
+   StartupStatus();
 
    StartupRootMenu();
 
@@ -575,6 +621,8 @@ void Shutdown(void)
       ShutdownDialogs();
 #  endif
    ShutdownPopup();
+   ShutdownOutline();
+   ShutdownStatus();
    ShutdownKeys();
    ShutdownPager();
    ShutdownRootMenu();
@@ -620,17 +668,20 @@ void Destroy(void)
    DestroyDialogs();
 #endif
    DestroyDock();
+   DestroyDynamicMenus();
    DestroyFonts();
    DestroyGroups();
    DestroyHints();
    DestroyIcons();
    DestroyKeys();
+   DestroyOutline();
    DestroyPager();
    DestroyPlacement();
    DestroyPopup();
    DestroyRootMenu();
    DestroyScreens();
    DestroySettings();
+   DestroyStatus();
    DestroySwallow();
    DestroyTaskBar();
    DestroyTray();
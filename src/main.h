@@ -43,9 +43,17 @@ extern XContext frameContext;
 extern char haveShape;
 extern int shapeEvent;
 #endif
+#ifdef USE_XSYNC
+extern char haveSync;
+extern int syncEvent;
+#endif
 #ifdef USE_XRENDER
 extern char haveRender;
 #endif
+#ifdef USE_COMPOSITE
+extern char haveComposite;
+extern int damageEvent;
+#endif
 
 extern char *configPath;
 
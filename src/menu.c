@@ -34,10 +34,14 @@ static char ShowSubmenu(Menu *menu, Menu *parent,
                         int x, int y);
 
 static void PatchMenu(Menu *menu);
+static void PatchMenuItem(MenuItem *item, char wait);
 static void UnpatchMenu(Menu *menu);
 static void CreateMenu(Menu *menu, int x, int y);
 static void HideMenu(Menu *menu);
 static void DrawMenu(Menu *menu);
+static void RenderMenu(Menu *menu, char active);
+static void LoadMenuIcons(Menu *menu);
+static void FreeMenuPixmaps(Menu *menu);
 
 static char MenuLoop(Menu *menu, RunMenuCommandType runner);
 static MenuSelectionType UpdateMotion(Menu *menu,
@@ -45,13 +49,16 @@ static MenuSelectionType UpdateMotion(Menu *menu,
                                       XEvent *event);
 
 static void UpdateMenu(Menu *menu);
-static void DrawMenuItem(Menu *menu, MenuItem *item, int index);
+static void CopyMenuItem(Menu *menu, int index, char active);
+static void DrawMenuItem(Menu *menu, MenuItem *item, int index, char active);
+static int GetMenuItemHeight(const Menu *menu, int index);
 static MenuItem *GetMenuItem(Menu *menu, int index);
 static int GetNextMenuIndex(Menu *menu);
 static int GetPreviousMenuIndex(Menu *menu);
 static int GetMenuIndex(Menu *menu, int index);
 static void SetPosition(Menu *tp, int index);
 static char IsMenuValid(const Menu *menu);
+static char HasSubmenu(const MenuItem *item);
 
 int menuShown = 0;
 
@@ -67,6 +74,9 @@ void InitializeMenu(Menu *menu)
 
    menu->textOffset = 0;
    menu->itemCount = 0;
+   menu->offsets = NULL;
+   menu->pixmap = None;
+   menu->activePixmap = None;
 
    /* Compute the max size needed */
    hasIcon = 0;
@@ -76,13 +86,10 @@ void InitializeMenu(Menu *menu)
    }
    menu->itemHeight = GetStringHeight(FONT_MENU);
    for(np = menu->items; np; np = np->next) {
+      /* Icons are loaded when the menu is first shown. */
+      np->icon = NULL;
       if(np->iconName) {
-         np->icon = LoadNamedIcon(np->iconName, 1, 1);
-         if(np->icon) {
-            hasIcon = 1;
-         }
-      } else {
-         np->icon = NULL;
+         hasIcon = 1;
       }
       menu->itemCount += 1;
    }
@@ -134,11 +141,13 @@ void InitializeMenu(Menu *menu)
             menu->width = temp;
          }
       }
-      if(hasIcon && !np->icon) {
+      if(hasIcon && !np->iconName) {
          np->icon = &emptyIcon;
       }
-      if(np->submenu) {
+      if(HasSubmenu(np)) {
          hasSubmenu = (menu->itemHeight + 3) / 4;
+      }
+      if(np->submenu) {
          InitializeMenu(np->submenu);
       }
    }
@@ -217,10 +226,36 @@ void DestroyMenu(Menu *menu)
       if(menu->offsets) {
          Release(menu->offsets);
       }
+      FreeMenuPixmaps(menu);
       Release(menu);
    }
 }
 
+/** Release cached menu renderings. */
+void ReleaseMenuPixmaps(Menu *menu)
+{
+   MenuItem *np;
+   for(np = menu->items; np; np = np->next) {
+      if(np->submenu) {
+         ReleaseMenuPixmaps(np->submenu);
+      }
+   }
+   FreeMenuPixmaps(menu);
+}
+
+/** Free the cached renderings of a single menu. */
+void FreeMenuPixmaps(Menu *menu)
+{
+   if(menu->pixmap != None) {
+      JXFreePixmap(display, menu->pixmap);
+      menu->pixmap = None;
+   }
+   if(menu->activePixmap != None) {
+      JXFreePixmap(display, menu->activePixmap);
+      menu->activePixmap = None;
+   }
+}
+
 /** Show a submenu. */
 char ShowSubmenu(Menu *menu, Menu *parent,
                  RunMenuCommandType runner,
@@ -248,26 +283,35 @@ void PatchMenu(Menu *menu)
 {
    MenuItem *item;
    for(item = menu->items; item; item = item->next) {
-      Menu *submenu = NULL;
-      switch(item->action.type) {
-      case MA_DESKTOP_MENU:
-         submenu = CreateDesktopMenu(1 << currentDesktop);
-         break;
-      case MA_SENDTO_MENU:
-         submenu = CreateSendtoMenu();
-         break;
-      case MA_DYNAMIC:
-         if(!item->submenu) {
-            submenu = ParseDynamicMenu(item->action.data.str);
-         }
-         break;
-      default:
-         break;
-      }
-      if(submenu) {
-         InitializeMenu(submenu);
-         item->submenu = submenu;
-      }
+      PatchMenuItem(item, 1);
+   }
+}
+
+/** Create the temporary submenu for a menu item (if any).
+ * @param item The menu item.
+ * @param wait Set to give a dynamic menu command time to finish.
+ */
+void PatchMenuItem(MenuItem *item, char wait)
+{
+   Menu *submenu = NULL;
+   switch(item->action.type) {
+   case MA_DESKTOP_MENU:
+      submenu = CreateDesktopMenu(1 << currentDesktop);
+      break;
+   case MA_SENDTO_MENU:
+      submenu = CreateSendtoMenu();
+      break;
+   case MA_DYNAMIC:
+      if(!item->submenu) {
+         submenu = ParseDynamicMenu(item->action.data.str, wait);
+      }
+      break;
+   default:
+      break;
+   }
+   if(submenu) {
+      InitializeMenu(submenu);
+      item->submenu = submenu;
    }
 }
 
@@ -423,8 +467,6 @@ void CreateMenu(Menu *menu, int x, int y)
                                  MENU_BORDER_SIZE,
                                  CopyFromParent, InputOutput,
                                  CopyFromParent, attrMask, &attr);
-   menu->pixmap = JXCreatePixmap(display, menu->window,
-                                 menu->width, menu->height, rootVisual.depth);
 
    if(settings.menuOpacity < UINT_MAX) {
       SetCardinalAtom(menu->window, ATOM_NET_WM_WINDOW_OPACITY,
@@ -435,35 +477,62 @@ void CreateMenu(Menu *menu, int x, int y)
 
 }
 
-/** Hide a menu. */
+/** Hide a menu.
+ * Note that the menu renderings are kept for the next time the
+ * menu is shown.
+ */
 void HideMenu(Menu *menu)
 {
    JXDestroyWindow(display, menu->window);
-   JXFreePixmap(display, menu->pixmap);
 }
 
 /** Draw a menu. */
 void DrawMenu(Menu *menu)
+{
+
+   if(menu->pixmap == None) {
+      RenderMenu(menu, 0);
+   }
+   JXCopyArea(display, menu->pixmap, menu->window, rootGC,
+              0, 0, menu->width, menu->height, 0, 0);
+
+   /* Draw the current selection. */
+   CopyMenuItem(menu, menu->currentIndex, 1);
+
+}
+
+/** Render a menu with all items either active or inactive.
+ * The rendering is cached until the menu is destroyed.
+ */
+void RenderMenu(Menu *menu, char active)
 {
 
    MenuItem *np;
+   Pixmap pixmap;
    int x;
 
+   LoadMenuIcons(menu);
+
+   pixmap = JXCreatePixmap(display, rootWindow, menu->width, menu->height,
+                           rootVisual.depth);
+   if(active) {
+      menu->activePixmap = pixmap;
+   } else {
+      menu->pixmap = pixmap;
+   }
+
    JXSetForeground(display, rootGC, colors[COLOR_MENU_BG]);
-   JXFillRectangle(display, menu->pixmap, rootGC, 0, 0,
-                   menu->width, menu->height);
+   JXFillRectangle(display, pixmap, rootGC, 0, 0, menu->width, menu->height);
 
-   if(menu->label) {
-      DrawMenuItem(menu, NULL, -1);
+   if(menu->label && !active) {
+      DrawMenuItem(menu, NULL, -1, 0);
    }
 
    x = 0;
    for(np = menu->items; np; np = np->next) {
-      DrawMenuItem(menu, np, x);
+      DrawMenuItem(menu, np, x, active);
       ++x;
    }
-   JXCopyArea(display, menu->pixmap, menu->window, rootGC,
-              0, 0, menu->width, menu->height, 0, 0);
 
 }
 
@@ -614,6 +683,14 @@ MenuSelectionType UpdateMotion(Menu *menu,
    if(menu->lastIndex != menu->currentIndex) {
       UpdateMenu(menu);
       menu->lastIndex = menu->currentIndex;
+
+      /* Dynamic menus may have been generated in the background
+       * since this menu was shown. */
+      ip = GetMenuItem(menu, menu->currentIndex);
+      if(ip && ip->action.type == MA_DYNAMIC && !ip->submenu) {
+         PatchMenuItem(ip, 0);
+      }
+
    }
 
    /* If the selected item is a submenu, show it. */
@@ -638,38 +715,79 @@ MenuSelectionType UpdateMotion(Menu *menu,
 
 }
 
-/** Update the menu selection. */
-void UpdateMenu(Menu *menu)
+/** Load the icons for a menu that has not been shown yet. */
+void LoadMenuIcons(Menu *menu)
 {
+   MenuItem *np;
+   for(np = menu->items; np; np = np->next) {
+      if(np->iconName && !np->icon) {
+         np->icon = LoadNamedIcon(np->iconName, 1, 1);
+         if(!np->icon) {
+            np->icon = &emptyIcon;
+         }
+      }
+   }
+}
 
-   MenuItem *ip;
+/** Update the menu selection.
+ * Only the items that changed are copied to the menu window.
+ */
+void UpdateMenu(Menu *menu)
+{
 
    /* Clear the old selection. */
-   ip = GetMenuItem(menu, menu->lastIndex);
-   DrawMenuItem(menu, ip, menu->lastIndex);
+   if(menu->lastIndex != menu->currentIndex) {
+      CopyMenuItem(menu, menu->lastIndex, 0);
+   }
 
    /* Highlight the new selection. */
-   ip = GetMenuItem(menu, menu->currentIndex);
-   if(ip != NULL) {
-      DrawMenuItem(menu, ip, menu->currentIndex);
+   CopyMenuItem(menu, menu->currentIndex, 1);
+
+}
+
+/** Copy a menu item from a cached rendering to the menu window. */
+void CopyMenuItem(Menu *menu, int index, char active)
+{
+
+   Pixmap pixmap;
+   int y;
+
+   if(index < 0) {
+      return;
    }
 
-   JXCopyArea(display, menu->pixmap, menu->window, rootGC,
-              0, 0, menu->width, menu->height, 0, 0);
+   if(active) {
+      if(menu->activePixmap == None) {
+         RenderMenu(menu, 1);
+      }
+      pixmap = menu->activePixmap;
+   } else {
+      if(menu->pixmap == None) {
+         RenderMenu(menu, 0);
+      }
+      pixmap = menu->pixmap;
+   }
+
+   y = menu->offsets[index];
+   JXCopyArea(display, pixmap, menu->window, rootGC,
+              0, y, menu->width, GetMenuItemHeight(menu, index), 0, y);
 
 }
 
 /** Draw a menu item. */
-void DrawMenuItem(Menu *menu, MenuItem *item, int index)
+void DrawMenuItem(Menu *menu, MenuItem *item, int index, char active)
 {
 
    ButtonNode button;
+   Pixmap pixmap;
 
    Assert(menu);
 
+   pixmap = active ? menu->activePixmap : menu->pixmap;
+
    if(!item) {
       if(index == -1 && menu->label) {
-         ResetButton(&button, menu->pixmap, &rootVisual);
+         ResetButton(&button, pixmap, &rootVisual);
          button.x = 0;
          button.y = 0;
          button.width = menu->width - 1;
@@ -686,8 +804,8 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
    if(item->type != MENU_ITEM_SEPARATOR) {
       ColorType fg;
 
-      ResetButton(&button, menu->pixmap, &rootVisual);
-      if(menu->currentIndex == index) {
+      ResetButton(&button, pixmap, &rootVisual);
+      if(active) {
          button.type = BUTTON_MENU_ACTIVE;
          fg = COLOR_MENU_ACTIVE_FG;
       } else {
@@ -704,7 +822,7 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
       button.icon = item->icon;
       DrawButton(&button);
 
-      if(item->submenu) {
+      if(HasSubmenu(item)) {
 
          const int asize = (menu->itemHeight + 7) / 8;
          const int y = menu->offsets[index] + (menu->itemHeight + 1) / 2;
@@ -715,16 +833,16 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
          for(i = 0; i < asize; i++) {
             const int y1 = y - asize + i;
             const int y2 = y + asize - i;
-            JXDrawLine(display, menu->pixmap, rootGC, x, y1, x, y2);
+            JXDrawLine(display, pixmap, rootGC, x, y1, x, y2);
             x += 1;
          }
-         JXDrawPoint(display, menu->pixmap, rootGC, x, y);
+         JXDrawPoint(display, pixmap, rootGC, x, y);
 
       }
 
    } else {
       JXSetForeground(display, rootGC, colors[COLOR_MENU_ACTIVE_FG]);
-      JXDrawLine(display, menu->pixmap, rootGC, 4,
+      JXDrawLine(display, pixmap, rootGC, 4,
                  menu->offsets[index] + 2, menu->width - 6,
                  menu->offsets[index] + 2);
    }
@@ -767,24 +885,43 @@ int GetPreviousMenuIndex(Menu *menu)
 
 }
 
-/** Get the item in the menu given a y-coordinate. */
+/** Get the item in the menu given a y-coordinate.
+ * The item offsets are sorted, so this is a binary search for the
+ * last item starting at or above y.
+ */
 int GetMenuIndex(Menu *menu, int y)
 {
 
-   int x;
+   int low, high;
 
    if(y < menu->offsets[0]) {
       return -1;
    }
-   for(x = 0; x < menu->itemCount - 1; x++) {
-      if(y >= menu->offsets[x] && y < menu->offsets[x + 1]) {
-         return x;
+
+   low = 0;
+   high = menu->itemCount - 1;
+   while(low < high) {
+      const int mid = (low + high + 1) / 2;
+      if(y < menu->offsets[mid]) {
+         high = mid - 1;
+      } else {
+         low = mid;
       }
    }
-   return x;
+   return low;
 
 }
 
+/** Get the height of the menu item at an index. */
+int GetMenuItemHeight(const Menu *menu, int index)
+{
+   if(index + 1 < menu->itemCount) {
+      return menu->offsets[index + 1] - menu->offsets[index];
+   } else {
+      return menu->height - menu->offsets[index];
+   }
+}
+
 /** Get the menu item associated with an index. */
 MenuItem *GetMenuItem(Menu *menu, int index)
 {
@@ -836,6 +973,19 @@ void SetPosition(Menu *tp, int index)
 
 }
 
+/** Determine if a menu item has (or will have) a submenu. */
+char HasSubmenu(const MenuItem *item)
+{
+   switch(item->action.type) {
+   case MA_DESKTOP_MENU:
+   case MA_SENDTO_MENU:
+   case MA_DYNAMIC:
+      return 1;
+   default:
+      return item->submenu != NULL;
+   }
+}
+
 /** Determine if a menu is valid (and can be shown). */
 char IsMenuValid(const Menu *menu)
 {
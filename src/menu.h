@@ -79,7 +79,8 @@ typedef struct Menu {
 
    /* These fields are handled by menu.c */
    Window window;          /**< The menu window. */
-   Pixmap pixmap;          /**< Pixmap where the menu is rendered. */
+   Pixmap pixmap;          /**< Cached rendering of the menu. */
+   Pixmap activePixmap;    /**< Cached rendering with active items. */
    int x;                  /**< The x-coordinate of the menu. */
    int y;                  /**< The y-coordinate of the menu. */
    int width;              /**< The width of the menu. */
@@ -114,6 +115,13 @@ void ShowMenu(Menu *menu, RunMenuCommandType runner, int x, int y);
  */
 void DestroyMenu(Menu *menu);
 
+/** Release the cached renderings of a menu and its submenus.
+ * The menu will be rendered again the next time it is shown.
+ * This must be called before the X connection is closed.
+ * @param menu The menu.
+ */
+void ReleaseMenuPixmaps(Menu *menu);
+
 /** The number of open menus. */
 extern int menuShown;
 
@@ -22,15 +22,28 @@
 #include "status.h"
 #include "tray.h"
 #include "desktop.h"
+#include "place.h"
 #include "settings.h"
 #include "timing.h"
 
+/** Minimum time in milliseconds between configure events during a move. */
+#define MOVE_CONFIGURE_DELAY  200
+
+/** Minimum time in milliseconds between pager updates during a move. */
+#define MOVE_PAGER_DELAY      100
+
 typedef struct {
    int left, right;
    int top, bottom;
    char valid;
 } RectangleType;
 
+/** An edge of a window used for snapping. */
+typedef struct {
+   int value;     /**< Position of the edge. */
+   int index;     /**< Index of the window in snapRects. */
+} SnapEdge;
+
 static char shouldStopMove;
 static char atLeft;
 static char atRight;
@@ -38,14 +51,38 @@ static char atBottom;
 static char atTop;
 static ClientNode *currentClient;
 static TimeType moveTime;
+static char movePending;
+static TimeType frameTime;
+static TimeType configureTime;
+static TimeType pagerTime;
+
+/* Windows to snap to in stacking order (bottom to top) and their
+ * edges sorted by position. This is built when a move starts and
+ * rebuilt if other windows or trays change during the move. */
+static RectangleType *snapRects = NULL;
+static SnapEdge *snapLeftEdges;
+static SnapEdge *snapRightEdges;
+static SnapEdge *snapTopEdges;
+static SnapEdge *snapBottomEdges;
+static int snapCount;
+static char snapDirty;
 
 static void StopMove(ClientNode *np, int doMove,
                      int oldx, int oldy, MaxFlags maxFlags);
 static void MoveController(int wasDestroyed);
+static void UpdateMoveFrame(ClientNode *np);
 
 static void DoSnap(ClientNode *np);
 static void DoSnapScreen(ClientNode *np);
 static void DoSnapBorder(ClientNode *np);
+static void CreateSnapIndex(const ClientNode *np);
+static void DestroySnapIndex(void);
+static int SnapEdgeComparator(const void *a, const void *b);
+static const RectangleType *FindSnapTarget(const SnapEdge *edges, int value,
+   const RectangleType *client,
+   char (*overlap)(const RectangleType*, const RectangleType*),
+   char (*valid)(const RectangleType*, const RectangleType*,
+                 const RectangleType*));
 static char ShouldSnap(const ClientNode *np);
 static void GetClientRectangle(const ClientNode *np, RectangleType *r);
 
@@ -82,7 +119,9 @@ void MoveController(int wasDestroyed)
    JXUngrabKeyboard(display, CurrentTime);
 
    DestroyMoveWindow();
+   DestroySnapIndex();
    shouldStopMove = 1;
+   movePending = 0;
    atTop = 0;
    atBottom = 0;
    atLeft = 0;
@@ -112,7 +151,17 @@ char MoveClient(ClientNode *np, int startx, int starty)
 
    GrabMouseForMove();
 
-   RegisterCallback(0, SignalMove, NULL);
+   /* Opaque moves are applied at most once per frame. */
+   movePending = 0;
+   frameTime.seconds = 0;
+   frameTime.ms = 0;
+   configureTime = frameTime;
+   pagerTime = frameTime;
+   if(settings.moveRate > 0) {
+      RegisterCallback(1000 / settings.moveRate, SignalMove, NULL);
+   } else {
+      RegisterCallback(0, SignalMove, NULL);
+   }
    np->controller = MoveController;
    shouldStopMove = 0;
 
@@ -133,6 +182,9 @@ char MoveClient(ClientNode *np, int startx, int starty)
    currentClient = np;
    atTop = atBottom = atLeft = atRight = 0;
    doMove = 0;
+   if(settings.snapMode == SNAP_BORDER) {
+      CreateSnapIndex(np);
+   }
    for(;;) {
 
       WaitForEvent(&event);
@@ -211,20 +263,18 @@ char MoveClient(ClientNode *np, int startx, int starty)
          if(doMove) {
 
             if(settings.moveMode == MOVE_OUTLINE) {
-               ClearOutline();
                height = north + south;
                if(!(np->state.status & STAT_SHADED)) {
                   height += np->height;
                }
                DrawOutline(np->x - west, np->y - north,
                            np->width + west + east, height);
+               UpdateMoveWindow(np);
+               UpdatePager();
             } else {
-               JXMoveWindow(display, np->parent, np->x - west,
-                            np->y - north);
-               SendConfigureEvent(np);
+               movePending = 1;
+               UpdateMoveFrame(np);
             }
-            UpdateMoveWindow(np);
-            UpdatePager();
          }
 
          break;
@@ -353,11 +403,11 @@ char MoveClientKeyboard(ClientNode *np)
       if(moved) {
 
          if(settings.moveMode == MOVE_OUTLINE) {
-            ClearOutline();
             DrawOutline(np->x - west, np->y - west,
                         np->width + west + east, height + north + west);
          } else {
             JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+            UpdateFreeSpace(np);
             SendConfigureEvent(np);
          }
 
@@ -403,7 +453,9 @@ void StopMove(ClientNode *np, int doMove,
    GetBorderSize(&np->state, &north, &south, &east, &west);
 
    JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+   UpdateFreeSpace(np);
    SendConfigureEvent(np);
+   UpdatePager();
 
    /* Restore maximized status. */
    if(maxFlags) {
@@ -412,6 +464,48 @@ void StopMove(ClientNode *np, int doMove,
 
 }
 
+/** Apply a pending opaque move if a frame is due.
+ * The synthetic configure event and the pager are updated at
+ * lower rates; StopMove takes care of the final update.
+ */
+void UpdateMoveFrame(ClientNode *np)
+{
+
+   TimeType now;
+   int north, south, east, west;
+
+   if(!movePending) {
+      return;
+   }
+
+   GetCurrentTime(&now);
+   if(settings.moveRate > 0) {
+      const unsigned long delay = 1000 / settings.moveRate;
+      if(GetTimeDifference(&now, &frameTime) < delay) {
+         return;
+      }
+   }
+   frameTime = now;
+   movePending = 0;
+
+   GetBorderSize(&np->state, &north, &south, &east, &west);
+   JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+   UpdateFreeSpace(np);
+   UpdateMoveWindow(np);
+
+   if(settings.moveRate == 0
+      || GetTimeDifference(&now, &configureTime) >= MOVE_CONFIGURE_DELAY) {
+      configureTime = now;
+      SendConfigureEvent(np);
+   }
+   if(settings.moveRate == 0
+      || GetTimeDifference(&now, &pagerTime) >= MOVE_PAGER_DELAY) {
+      pagerTime = now;
+      UpdatePager();
+   }
+
+}
+
 /** Snap to the screen and/or neighboring windows. */
 void DoSnap(ClientNode *np)
 {
@@ -471,114 +565,213 @@ void DoSnapScreen(ClientNode *np)
 void DoSnapBorder(ClientNode *np)
 {
 
-   const ClientNode *tp;
-   const TrayType *tray;
-   RectangleType client, other;
-   RectangleType left = { 0 };
-   RectangleType right = { 0 };
-   RectangleType top = { 0 };
-   RectangleType bottom = { 0 };
-   int layer;
+   RectangleType client;
+   const RectangleType *left, *right, *top, *bottom;
    int north, south, east, west;
 
+   if(snapDirty) {
+      DestroySnapIndex();
+      CreateSnapIndex(np);
+   }
+   if(snapCount == 0) {
+      return;
+   }
+
    GetClientRectangle(np, &client);
 
    GetBorderSize(&np->state, &north, &south, &east, &west);
 
-   other.valid = 1;
-
-   /* Work from the bottom of the window stack to the top. */
-   for(layer = 0; layer < LAYER_COUNT; layer++) {
+   left = FindSnapTarget(snapRightEdges, client.left, &client,
+                         CheckOverlapTopBottom, CheckLeftValid);
+   right = FindSnapTarget(snapLeftEdges, client.right, &client,
+                          CheckOverlapTopBottom, CheckRightValid);
+   top = FindSnapTarget(snapBottomEdges, client.top, &client,
+                        CheckOverlapLeftRight, CheckTopValid);
+   bottom = FindSnapTarget(snapTopEdges, client.bottom, &client,
+                           CheckOverlapLeftRight, CheckBottomValid);
 
-      /* Check tray windows. */
-      for(tray = GetTrays(); tray; tray = tray->next) {
+   if(right) {
+      np->x = right->left - np->width - west;
+   }
+   if(left) {
+      np->x = left->right + east;
+   }
+   if(bottom) {
+      np->y = bottom->top - south;
+      if(!(np->state.status & STAT_SHADED)) {
+         np->y -= np->height;
+      }
+   }
+   if(top) {
+      np->y = top->bottom + north;
+   }
 
-         if(tray->hidden) {
-            continue;
-         }
+}
 
-         other.left = tray->x;
-         other.right = tray->x + tray->width;
-         other.top = tray->y;
-         other.bottom = tray->y + tray->height;
+/** Find the window to snap one side of the moving window to.
+ * The target is the highest window with a matching edge within the
+ * snap distance that is not hidden by a window above it.
+ * @param edges The edges to check, sorted by position.
+ * @param value The position of the side of the moving window.
+ * @param client The moving window.
+ * @param overlap Check if a window lines up with the moving window.
+ * @param valid Check if a window is still a target given a higher window.
+ * @return The window to snap to or NULL if there is none.
+ */
+const RectangleType *FindSnapTarget(const SnapEdge *edges, int value,
+   const RectangleType *client,
+   char (*overlap)(const RectangleType*, const RectangleType*),
+   char (*valid)(const RectangleType*, const RectangleType*,
+                 const RectangleType*))
+{
 
-         left.valid = CheckLeftValid(&client, &other, &left);
-         right.valid = CheckRightValid(&client, &other, &right);
-         top.valid = CheckTopValid(&client, &other, &top);
-         bottom.valid = CheckBottomValid(&client, &other, &bottom);
+   const RectangleType *target;
+   int low, high;
+   int best;
+   int x;
+
+   /* Find the first edge within the snap distance. */
+   low = 0;
+   high = snapCount;
+   while(low < high) {
+      const int mid = (low + high) / 2;
+      if(edges[mid].value < value - settings.snapDistance) {
+         low = mid + 1;
+      } else {
+         high = mid;
+      }
+   }
 
-         if(CheckOverlapTopBottom(&client, &other)) {
-            if(abs(client.left - other.right) <= settings.snapDistance) {
-               left = other;
-            }
-            if(abs(client.right - other.left) <= settings.snapDistance) {
-               right = other;
-            }
-         }
-         if(CheckOverlapLeftRight(&client, &other)) {
-            if(abs(client.top - other.bottom) <= settings.snapDistance) {
-               top = other;
-            }
-            if(abs(client.bottom - other.top) <= settings.snapDistance) {
-               bottom = other;
-            }
-         }
+   /* Use the highest window in range. */
+   best = -1;
+   for(x = low; x < snapCount; x++) {
+      const int index = edges[x].index;
+      if(edges[x].value > value + settings.snapDistance) {
+         break;
+      }
+      if(index > best && (overlap)(client, &snapRects[index])) {
+         best = index;
+      }
+   }
+   if(best < 0) {
+      return NULL;
+   }
 
+   /* Make sure no higher window hides the edge. */
+   target = &snapRects[best];
+   for(x = best + 1; x < snapCount; x++) {
+      if(!(valid)(client, &snapRects[x], target)) {
+         return NULL;
       }
+   }
 
-      /* Check client windows. */
-      for(tp = nodeTail[layer]; tp; tp = tp->prev) {
+   return target;
 
-         if(tp == np || !ShouldSnap(tp)) {
-            continue;
-         }
+}
+
+/** Build the index of windows to snap to. */
+void CreateSnapIndex(const ClientNode *np)
+{
+
+   const ClientNode *tp;
+   const TrayType *tray;
+   int layer;
+   int pass;
+   int x;
 
-         GetClientRectangle(tp, &other);
+   /* The first pass counts the windows, the second pass fills
+    * in the rectangles. */
+   snapDirty = 0;
+   snapRects = NULL;
+   for(pass = 0; pass < 2; pass++) {
 
-         /* Check if this border invalidates any previous value. */
-         left.valid = CheckLeftValid(&client, &other, &left);
-         right.valid = CheckRightValid(&client, &other, &right);
-         top.valid = CheckTopValid(&client, &other, &top);
-         bottom.valid = CheckBottomValid(&client, &other, &bottom);
+      snapCount = 0;
 
-         /* Compute the new snap values. */
-         if(CheckOverlapTopBottom(&client, &other)) {
-            if(abs(client.left - other.right) <= settings.snapDistance) {
-               left = other;
+      /* Work from the bottom of the window stack to the top. */
+      for(layer = 0; layer < LAYER_COUNT; layer++) {
+
+         /* Tray windows. */
+         for(tray = GetTrays(); tray; tray = tray->next) {
+            if(tray->hidden) {
+               continue;
             }
-            if(abs(client.right - other.left) <= settings.snapDistance) {
-               right = other;
+            if(snapRects) {
+               RectangleType *r = &snapRects[snapCount];
+               r->left = tray->x;
+               r->right = tray->x + tray->width;
+               r->top = tray->y;
+               r->bottom = tray->y + tray->height;
+               r->valid = 1;
             }
+            snapCount += 1;
          }
-         if(CheckOverlapLeftRight(&client, &other)) {
-            if(abs(client.top - other.bottom) <= settings.snapDistance) {
-               top = other;
+
+         /* Client windows. */
+         for(tp = nodeTail[layer]; tp; tp = tp->prev) {
+            if(tp == np || !ShouldSnap(tp)) {
+               continue;
             }
-            if(abs(client.bottom - other.top) <= settings.snapDistance) {
-               bottom = other;
+            if(snapRects) {
+               GetClientRectangle(tp, &snapRects[snapCount]);
             }
+            snapCount += 1;
          }
 
       }
 
-   }
+      if(snapCount == 0) {
+         return;
+      }
+      if(!snapRects) {
+         snapRects = Allocate(sizeof(RectangleType) * snapCount);
+      }
 
-   if(right.valid) {
-      np->x = right.left - np->width - west;
-   }
-   if(left.valid) {
-      np->x = left.right + east;
    }
-   if(bottom.valid) {
-      np->y = bottom.top - south;
-      if(!(np->state.status & STAT_SHADED)) {
-         np->y -= np->height;
-      }
+
+   snapLeftEdges = Allocate(sizeof(SnapEdge) * snapCount * 4);
+   snapRightEdges = &snapLeftEdges[snapCount];
+   snapTopEdges = &snapRightEdges[snapCount];
+   snapBottomEdges = &snapTopEdges[snapCount];
+   for(x = 0; x < snapCount; x++) {
+      snapLeftEdges[x].value = snapRects[x].left;
+      snapLeftEdges[x].index = x;
+      snapRightEdges[x].value = snapRects[x].right;
+      snapRightEdges[x].index = x;
+      snapTopEdges[x].value = snapRects[x].top;
+      snapTopEdges[x].index = x;
+      snapBottomEdges[x].value = snapRects[x].bottom;
+      snapBottomEdges[x].index = x;
    }
-   if(top.valid) {
-      np->y = top.bottom + north;
+   qsort(snapLeftEdges, snapCount, sizeof(SnapEdge), SnapEdgeComparator);
+   qsort(snapRightEdges, snapCount, sizeof(SnapEdge), SnapEdgeComparator);
+   qsort(snapTopEdges, snapCount, sizeof(SnapEdge), SnapEdgeComparator);
+   qsort(snapBottomEdges, snapCount, sizeof(SnapEdge), SnapEdgeComparator);
+
+}
+
+/** Release the index of windows to snap to. */
+void DestroySnapIndex(void)
+{
+   if(snapRects) {
+      Release(snapRects);
+      Release(snapLeftEdges);
+      snapRects = NULL;
    }
+   snapCount = 0;
+}
 
+/** Mark the index of windows to snap to as out of date. */
+void InvalidateSnapIndex(void)
+{
+   snapDirty = 1;
+}
+
+/** Comparator for sorting snap edges by position. */
+int SnapEdgeComparator(const void *a, const void *b)
+{
+   const SnapEdge *ea = (const SnapEdge*)a;
+   const SnapEdge *eb = (const SnapEdge*)b;
+   return ea->value - eb->value;
 }
 
 /** Determine if we should snap to the specified client. */
@@ -772,6 +965,9 @@ char CheckBottomValid(const RectangleType *client,
 void SignalMove(const TimeType *now, int x, int y, Window w, void *data)
 {
    UpdateDesktop(now);
+   if(movePending) {
+      UpdateMoveFrame(currentClient);
+   }
 }
 
 /** Switch to the specified desktop. */
@@ -785,17 +981,15 @@ void UpdateDesktop(const TimeType *now)
    }
    moveTime = *now;
 
-   if(atLeft && LeftDesktop()) {
-      SetClientDesktop(currentClient, currentDesktop);
-      RestackClients();
-   } else if(atRight && RightDesktop()) {
-      SetClientDesktop(currentClient, currentDesktop);
-      RestackClients();
-   } else if(atTop && AboveDesktop()) {
-      SetClientDesktop(currentClient, currentDesktop);
-      RestackClients();
-   } else if(atBottom && BelowDesktop()) {
+   if(   (atLeft && LeftDesktop())
+      || (atRight && RightDesktop())
+      || (atTop && AboveDesktop())
+      || (atBottom && BelowDesktop())) {
       SetClientDesktop(currentClient, currentDesktop);
       RestackClients();
+      if(settings.snapMode == SNAP_BORDER) {
+         DestroySnapIndex();
+         CreateSnapIndex(currentClient);
+      }
    }
 }
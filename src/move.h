@@ -26,5 +26,10 @@ char MoveClient(struct ClientNode *np, int startx, int starty);
  */
 char MoveClientKeyboard(struct ClientNode *np);
 
+/** Mark the windows used for snapping during a move as out of date.
+ * This should be called when client or tray geometry changes.
+ */
+void InvalidateSnapIndex(void);
+
 #endif /* MOVE_H */
 
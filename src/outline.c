@@ -5,44 +5,116 @@
  *
  * @brief Outlines for moving and resizing client windows.
  *
+ * The outline is made up of four thin override-redirect windows that
+ * are created once and then moved and resized, so no server grab is
+ * needed while other clients continue to draw.
+ *
  */
 
 #include "jwm.h"
 #include "outline.h"
 #include "main.h"
-#include "grab.h"
+#include "color.h"
+#include "misc.h"
+
+/** Thickness of the outline. */
+#define OUTLINE_WIDTH 2
+
+static Window outlineWindows[4];
+static char outlineShown;
+
+static void CreateOutline(void);
+
+/** Initialize outline data. */
+void InitializeOutline(void)
+{
+   int i;
+   for(i = 0; i < 4; i++) {
+      outlineWindows[i] = None;
+   }
+   outlineShown = 0;
+}
+
+/** Create the outline windows. */
+void CreateOutline(void)
+{
+
+   XSetWindowAttributes attrs;
+   long attrMask;
+   int i;
+
+   attrMask = 0;
+
+   attrMask |= CWBackPixel;
+   attrs.background_pixel = colors[COLOR_BORDER_ACTIVE_LINE];
+
+   attrMask |= CWSaveUnder;
+   attrs.save_under = True;
+
+   attrMask |= CWOverrideRedirect;
+   attrs.override_redirect = True;
 
-static GC outlineGC = None;
-static int lastX, lastY;
-static int lastWidth, lastHeight;
+   for(i = 0; i < 4; i++) {
+      outlineWindows[i] = JXCreateWindow(display, rootWindow, 0, 0, 1, 1, 0,
+                                         CopyFromParent, InputOutput,
+                                         CopyFromParent, attrMask, &attrs);
+   }
+
+}
+
+/** Shutdown outline support. */
+void ShutdownOutline(void)
+{
+   int i;
+   if(outlineWindows[0] != None) {
+      for(i = 0; i < 4; i++) {
+         JXDestroyWindow(display, outlineWindows[i]);
+         outlineWindows[i] = None;
+      }
+   }
+   outlineShown = 0;
+}
 
 /** Draw an outline. */
 void DrawOutline(int x, int y, int width, int height)
 {
-   XGCValues gcValues;
-   gcValues.function = GXinvert;
-   gcValues.subwindow_mode = IncludeInferiors;
-   gcValues.line_width = 2;
-   outlineGC = JXCreateGC(display, rootWindow,
-                          GCFunction | GCSubwindowMode | GCLineWidth,
-                          &gcValues);
-   GrabServer();
-   JXDrawRectangle(display, rootWindow, outlineGC, x, y, width, height);
-   lastX = x;
-   lastY = y;
-   lastWidth = width;
-   lastHeight = height;
+
+   const int w = Max(width + 1, 2 * OUTLINE_WIDTH);
+   const int h = Max(height + 1, 2 * OUTLINE_WIDTH);
+   int i;
+
+   if(outlineWindows[0] == None) {
+      CreateOutline();
+   }
+
+   JXMoveResizeWindow(display, outlineWindows[0],
+                      x, y, w, OUTLINE_WIDTH);
+   JXMoveResizeWindow(display, outlineWindows[1],
+                      x, y + h - OUTLINE_WIDTH, w, OUTLINE_WIDTH);
+   JXMoveResizeWindow(display, outlineWindows[2],
+                      x, y + OUTLINE_WIDTH,
+                      OUTLINE_WIDTH, h - 2 * OUTLINE_WIDTH);
+   JXMoveResizeWindow(display, outlineWindows[3],
+                      x + w - OUTLINE_WIDTH, y + OUTLINE_WIDTH,
+                      OUTLINE_WIDTH, h - 2 * OUTLINE_WIDTH);
+
+   if(!outlineShown) {
+      for(i = 0; i < 4; i++) {
+         JXMapRaised(display, outlineWindows[i]);
+      }
+      outlineShown = 1;
+   }
+
 }
 
 /** Clear the last outline. */
 void ClearOutline(void)
 {
-   if(outlineGC != None) {
-      JXDrawRectangle(display, rootWindow, outlineGC,
-                      lastX, lastY, lastWidth, lastHeight);
-      UngrabServer();
-      JXFreeGC(display, outlineGC);
-      outlineGC = None;
+   int i;
+   if(outlineShown) {
+      for(i = 0; i < 4; i++) {
+         JXUnmapWindow(display, outlineWindows[i]);
+      }
+      outlineShown = 0;
    }
 }
-
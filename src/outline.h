@@ -10,7 +10,15 @@
 #ifndef OUTLINE_H
 #define OUTLINE_H
 
+/*@{*/
+void InitializeOutline(void);
+#define StartupOutline()   (void)(0)
+void ShutdownOutline(void);
+#define DestroyOutline()   (void)(0)
+/*@}*/
+
 /** Draw an outline.
+ * If an outline is already shown, it is moved to the new location.
  * @param x The x-coordinate.
  * @param y The y-coordinate.
  * @param width The width of the outline.
@@ -21,6 +21,66 @@
 #include "popup.h"
 #include "font.h"
 #include "settings.h"
+#include "misc.h"
+#include "place.h"
+
+#ifdef USE_COMPOSITE
+
+/** Minimum time in milliseconds between thumbnail refreshes. */
+#define PAGER_THUMBNAIL_DELAY 100
+
+/** Structure to represent the thumbnail of a window on a pager. */
+typedef struct PagerThumbnailType {
+   Window window;             /**< The client window. */
+   Damage damage;             /**< Damage tracking for the window. */
+   Picture source;            /**< Picture for the client window. */
+   Pixmap pixmap;             /**< Scaled contents of the window. */
+   Picture picture;           /**< Picture for the scaled contents. */
+   int width, height;         /**< Size of the scaled contents. */
+   unsigned int serial;       /**< Changed when the contents change. */
+   char valid;                /**< Set if the scaled contents are valid. */
+   char dirty;                /**< Set if the window changed. */
+   char used;                 /**< Set if used in the last update. */
+   struct PagerThumbnailType *next;
+} PagerThumbnailType;
+
+#endif
+
+/** Structure to represent a client drawn on a pager. */
+typedef struct PagerClientType {
+   ClientNode *client;        /**< The client. */
+   int x, y;                  /**< Location within the desktop cell. */
+   int width, height;         /**< Size on the pager. */
+   ColorType color;           /**< Fill color. */
+#ifdef USE_COMPOSITE
+   PagerThumbnailType *thumbnail;   /**< Thumbnail (or NULL). */
+   unsigned int serial;             /**< Serial of the thumbnail. */
+#endif
+} PagerClientType;
+
+/** Number of rows and columns in the grid used to find clients. */
+#define PAGER_GRID_SIZE 4
+
+/** Structure to represent the contents of a desktop on a pager. */
+typedef struct PagerCellType {
+   PagerClientType *clients;  /**< Clients from bottom to top. */
+   unsigned int count;        /**< Number of clients. */
+   unsigned int max;          /**< Size of the clients array. */
+   char active;               /**< Set for the current desktop. */
+
+   /** Start of the client indexes for each grid square in gridItems. */
+   unsigned int gridStart[PAGER_GRID_SIZE * PAGER_GRID_SIZE + 1];
+   unsigned int *gridItems;   /**< Client indexes by grid square. */
+   unsigned int gridMax;      /**< Size of the gridItems array. */
+   char gridValid;            /**< Set if the grid matches the clients. */
+} PagerCellType;
+
+/** Structure to represent a pre-rendered desktop label. */
+typedef struct PagerLabelType {
+   char *name;                /**< Name used to render the label. */
+   int width;                 /**< Width of the label. */
+   Pixmap pixmaps[2];         /**< Label on the normal and active colors. */
+} PagerLabelType;
 
 /** Structure to represent a pager tray component. */
 typedef struct PagerType {
@@ -32,17 +92,35 @@ typedef struct PagerType {
    int scalex;             /**< Horizontal scale factor (fixed point). */
    int scaley;             /**< Vertical scale factor (fixed point). */
    char labeled;           /**< Set to label the pager. */
+   char thumbnails;        /**< Set to draw window thumbnails. */
 
    Pixmap buffer;          /**< Buffer for rendering the pager. */
+   PagerCellType *cells;   /**< Contents of each desktop in the buffer. */
+   char valid;             /**< Set if the buffer matches cells. */
 
    TimeType mouseTime;     /**< Timestamp of last mouse movement. */
    int mousex, mousey;     /**< Coordinates of last mouse location. */
 
+#ifdef USE_COMPOSITE
+   PagerThumbnailType *thumbnailList;  /**< Window thumbnails. */
+   TimeType refreshTime;   /**< Time thumbnails were last refreshed. */
+   char canRefresh;        /**< Set if thumbnails may be refreshed. */
+   char refreshPending;    /**< Set if thumbnails need to be refreshed. */
+#endif
+
    struct PagerType *next; /**< Next pager in the list. */
 
 } PagerType;
 
 static PagerType *pagers = NULL;
+static PagerCellType *scratchCells = NULL;
+static PagerLabelType *labels = NULL;
+static int labelHeight;
+
+#ifdef USE_COMPOSITE
+static char redirected = 0;
+static unsigned int thumbnailSerial = 0;
+#endif
 
 static char shouldStopMove;
 
@@ -65,7 +143,30 @@ static void StopPagerMove(ClientNode *np,
 
 static void PagerMoveController(int wasDestroyed);
 
-static void DrawPagerClient(const PagerType *pp, const ClientNode *np);
+static void AddPagerClient(PagerType *pp, PagerCellType *cells,
+                           ClientNode *np);
+static char ComparePagerCells(const PagerCellType *a,
+                              const PagerCellType *b);
+static void DrawPagerCell(const PagerType *pp, unsigned int desktop);
+static Pixmap GetPagerLabel(unsigned int desktop, char active, int *width);
+static void FreePagerCells(PagerCellType *cells);
+static void BuildPagerGrid(const PagerType *pp, PagerCellType *cell);
+static void GetPagerGridSquare(const PagerType *pp, int x, int y,
+                               int *gx, int *gy);
+static ClientNode *FindPagerClient(PagerType *pp, int desktop,
+                                   int x, int y);
+
+#ifdef USE_COMPOSITE
+static PagerThumbnailType *GetPagerThumbnail(PagerType *pp,
+                                             const ClientNode *np,
+                                             int width, int height);
+static void RefreshPagerThumbnail(PagerThumbnailType *tp,
+                                  const ClientNode *np);
+static void DestroyPagerThumbnail(PagerThumbnailType *tp);
+static void SweepPagerThumbnails(PagerType *pp);
+static void SignalPagerThumbnails(const TimeType *now, int x, int y,
+                                  Window w, void *data);
+#endif
 
 static void SignalPager(const TimeType *now, int x, int y, Window w,
                         void *data);
@@ -75,17 +176,73 @@ static void SignalPager(const TimeType *now, int x, int y, Window w,
 void ShutdownPager(void)
 {
    PagerType *pp;
+   unsigned int x;
    for(pp = pagers; pp; pp = pp->next) {
       JXFreePixmap(display, pp->buffer);
+      FreePagerCells(pp->cells);
+      pp->cells = NULL;
+#ifdef USE_COMPOSITE
+      while(pp->thumbnailList) {
+         PagerThumbnailType *tp = pp->thumbnailList->next;
+         DestroyPagerThumbnail(pp->thumbnailList);
+         pp->thumbnailList = tp;
+      }
+#endif
+   }
+#ifdef USE_COMPOSITE
+   if(redirected) {
+      JXCompositeUnredirectSubwindows(display, rootWindow,
+                                      CompositeRedirectAutomatic);
+      redirected = 0;
+   }
+#endif
+   if(scratchCells) {
+      FreePagerCells(scratchCells);
+      scratchCells = NULL;
+   }
+   if(labels) {
+      for(x = 0; x < settings.desktopCount; x++) {
+         if(labels[x].name) {
+            Release(labels[x].name);
+         }
+         if(labels[x].pixmaps[0] != None) {
+            JXFreePixmap(display, labels[x].pixmaps[0]);
+         }
+         if(labels[x].pixmaps[1] != None) {
+            JXFreePixmap(display, labels[x].pixmaps[1]);
+         }
+      }
+      Release(labels);
+      labels = NULL;
    }
 }
 
+/** Release the contents of pager cells. */
+void FreePagerCells(PagerCellType *cells)
+{
+   unsigned int x;
+   for(x = 0; x < settings.desktopCount; x++) {
+      if(cells[x].clients) {
+         Release(cells[x].clients);
+      }
+      if(cells[x].gridItems) {
+         Release(cells[x].gridItems);
+      }
+   }
+   Release(cells);
+}
+
 /** Release pager data. */
 void DestroyPager(void)
 {
    PagerType *pp;
    while(pagers) {
       UnregisterCallback(SignalPager, pagers);
+#ifdef USE_COMPOSITE
+      if(pagers->thumbnails) {
+         UnregisterCallback(SignalPagerThumbnails, pagers);
+      }
+#endif
       pp = pagers->next;
       Release(pagers);
       pagers = pp;
@@ -93,7 +250,7 @@ void DestroyPager(void)
 }
 
 /** Create a new pager tray component. */
-TrayComponentType *CreatePager(char labeled)
+TrayComponentType *CreatePager(char labeled, char thumbnails)
 {
 
    TrayComponentType *cp;
@@ -103,6 +260,9 @@ TrayComponentType *CreatePager(char labeled)
    pp->next = pagers;
    pagers = pp;
    pp->labeled = labeled;
+   pp->thumbnails = thumbnails;
+   pp->cells = NULL;
+   pp->valid = 0;
    pp->mousex = -settings.doubleClickDelta;
    pp->mousey = -settings.doubleClickDelta;
    pp->mouseTime.seconds = 0;
@@ -118,6 +278,16 @@ TrayComponentType *CreatePager(char labeled)
 
    RegisterCallback(settings.popupDelay / 2, SignalPager, pp);
 
+#ifdef USE_COMPOSITE
+   pp->thumbnailList = NULL;
+   pp->refreshTime.seconds = 0;
+   pp->refreshTime.ms = 0;
+   pp->refreshPending = 0;
+   if(thumbnails) {
+      RegisterCallback(PAGER_THUMBNAIL_DELAY, SignalPagerThumbnails, pp);
+   }
+#endif
+
    return cp;
 }
 
@@ -139,6 +309,30 @@ void Create(TrayComponentType *cp)
    cp->pixmap = JXCreatePixmap(display, rootWindow, cp->width,
                                cp->height, rootVisual.depth);
    pp->buffer = cp->pixmap;
+   pp->valid = 0;
+
+   if(!pp->cells) {
+      pp->cells = Allocate(settings.desktopCount * sizeof(PagerCellType));
+      memset(pp->cells, 0, settings.desktopCount * sizeof(PagerCellType));
+   }
+   if(!scratchCells) {
+      scratchCells = Allocate(settings.desktopCount * sizeof(PagerCellType));
+      memset(scratchCells, 0, settings.desktopCount * sizeof(PagerCellType));
+   }
+   if(pp->labeled && !labels) {
+      labels = Allocate(settings.desktopCount * sizeof(PagerLabelType));
+      memset(labels, 0, settings.desktopCount * sizeof(PagerLabelType));
+      labelHeight = GetStringHeight(FONT_PAGER);
+   }
+
+#ifdef USE_COMPOSITE
+   /* Keep the contents of windows so thumbnails can be drawn. */
+   if(pp->thumbnails && haveComposite && !redirected) {
+      JXCompositeRedirectSubwindows(display, rootWindow,
+                                    CompositeRedirectAutomatic);
+      redirected = 1;
+   }
+#endif
 
 }
 
@@ -182,6 +376,7 @@ void SetSize(TrayComponentType *cp, int width, int height)
 
    pp->scalex = ((pp->deskWidth - 2) << 16) / rootWidth;
    pp->scaley = ((pp->deskHeight - 2) << 16) / rootHeight;
+   pp->valid = 0;
 
 }
 
@@ -254,10 +449,7 @@ void StartPagerMove(TrayComponentType *cp, int x, int y)
    XEvent event;
    PagerType *pp;
    ClientNode *np;
-   int layer;
    int desktop;
-   int cx, cy;
-   int cwidth, cheight;
 
    int north, south, east, west;
    int oldx, oldy;
@@ -273,78 +465,11 @@ void StartPagerMove(TrayComponentType *cp, int x, int y)
    y -= (desktop / settings.desktopWidth) * (pp->deskHeight + 1);
 
    /* Find the client under the specified coordinates. */
-   for(layer = LAST_LAYER; layer >= FIRST_LAYER; layer--) {
-      for(np = nodes[layer]; np; np = np->next) {
-
-         /* Skip this client if it isn't mapped. */
-         if(!(np->state.status & STAT_MAPPED)) {
-            continue;
-         }
-         if(np->state.status & STAT_NOPAGER) {
-            continue;
-         }
-
-         /* Skip this client if it isn't on the selected desktop. */
-         if(np->state.status & STAT_STICKY) {
-            if(currentDesktop != desktop) {
-               continue;
-            }
-         } else {
-            if(np->state.desktop != desktop) {
-               continue;
-            }
-         }
-
-         /* Get the offset and size of the client on the pager. */
-         cx = 1 + ((np->x * pp->scalex) >> 16);
-         cy = 1 + ((np->y * pp->scaley) >> 16);
-         cwidth = (np->width * pp->scalex) >> 16;
-         cheight = (np->height * pp->scaley) >> 16;
-
-         /* Normalize the offset and size. */
-         if(cx + cwidth > pp->deskWidth) {
-            cwidth = pp->deskWidth - cx;
-         }
-         if(cy + cheight > pp->deskHeight) {
-            cheight = pp->deskHeight - cy;
-         }
-         if(cx < 0) {
-            cwidth += cx;
-            cx = 0;
-         }
-         if(cy < 0) {
-            cheight += cy;
-            cy = 0;
-         }
-
-         /* Skip the client if we are no longer in bounds. */
-         if(cwidth <= 0 || cheight <= 0) {
-            continue;
-         }
-
-         /* Check the y-coordinate. */
-         if(y < cy || y > cy + cheight) {
-            continue;
-         }
-
-         /* Check the x-coordinate. */
-         if(x < cx || x > cx + cwidth) {
-            continue;
-         }
-
-         /* Found it. Exit. */
-         goto ClientFound;
-
-      }
+   np = FindPagerClient(pp, desktop, x, y);
+   if(!np) {
+      return;
    }
 
-   /* Client wasn't found. Just return. */
-   return;
-
-ClientFound:
-
-   Assert(np);
-
    /* The selected client was found. Now make sure we can move it. */
    if(!(np->state.border & BORDER_MOVE)) {
       return;
@@ -437,6 +562,7 @@ ClientFound:
          np->x = oldx;
          np->y = oldy;
          JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+         UpdateFreeSpace(np);
          SendConfigureEvent(np);
          UpdatePager();
 
@@ -468,6 +594,7 @@ void StopPagerMove(ClientNode *np,
 
    GetBorderSize(&np->state, &north, &south, &east, & west);
    JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+   UpdateFreeSpace(np);
    SendConfigureEvent(np);
 
    /* Restore the maximized state of the client. */
@@ -490,7 +617,10 @@ void PagerMoveController(int wasDestroyed)
 
 }
 
-/** Update the pager. */
+/** Update the pager.
+ * The contents of each desktop are compared with what was last drawn
+ * so that only desktops that changed are redrawn.
+ */
 void UpdatePager(void)
 {
 
@@ -500,10 +630,7 @@ void UpdatePager(void)
    int width, height;
    int deskWidth, deskHeight;
    unsigned int x;
-   const char *name;
-   int xc, yc;
-   int textWidth, textHeight;
-   int dx, dy;
+   char damaged;
 
    if(JUNLIKELY(shouldExit)) {
       return;
@@ -511,50 +638,66 @@ void UpdatePager(void)
 
    for(pp = pagers; pp; pp = pp->next) {
 
+      if(JUNLIKELY(!pp->cells)) {
+         continue;
+      }
+
       buffer = pp->cp->pixmap;
       width = pp->cp->width;
       height = pp->cp->height;
       deskWidth = pp->deskWidth;
       deskHeight = pp->deskHeight;
 
-      /* Draw the background. */
-      JXSetForeground(display, rootGC, colors[COLOR_PAGER_BG]);
-      JXFillRectangle(display, buffer, rootGC, 0, 0, width, height);
-
-      /* Highlight the current desktop. */
-      JXSetForeground(display, rootGC, colors[COLOR_PAGER_ACTIVE_BG]);
-      dx = currentDesktop % settings.desktopWidth;
-      dy = currentDesktop / settings.desktopWidth;
-      JXFillRectangle(display, buffer, rootGC,
-                      dx * (deskWidth + 1), dy * (deskHeight + 1),
-                      deskWidth, deskHeight);
-
-      /* Draw the labels. */
-      if(pp->labeled) {
-         textHeight = GetStringHeight(FONT_PAGER);
-         if(textHeight < deskHeight) {
-            for(x = 0; x < settings.desktopCount; x++) {
-               dx = x % settings.desktopWidth;
-               dy = x / settings.desktopWidth;
-               name = GetDesktopName(x);
-               textWidth = GetStringWidth(FONT_PAGER, name);
-               if(textWidth < deskWidth) {
-                  xc = dx * (deskWidth + 1) + (deskWidth - textWidth) / 2;
-                  yc = dy * (deskHeight + 1) + (deskHeight - textHeight) / 2;
-                  RenderString(&rootVisual, buffer, FONT_PAGER,
-                               COLOR_PAGER_TEXT, xc, yc, deskWidth, name);
-               }
-            }
+#ifdef USE_COMPOSITE
+      /* Limit how often thumbnails are refreshed. */
+      if(pp->thumbnails && haveComposite) {
+         TimeType now;
+         GetCurrentTime(&now);
+         pp->canRefresh = GetTimeDifference(&now, &pp->refreshTime)
+                        >= PAGER_THUMBNAIL_DELAY;
+         if(pp->canRefresh) {
+            pp->refreshTime = now;
          }
       }
+#endif
 
-      /* Draw the clients. */
+      /* Determine the contents of each desktop. */
+      for(x = 0; x < settings.desktopCount; x++) {
+         scratchCells[x].count = 0;
+         scratchCells[x].active = x == currentDesktop;
+      }
       for(x = FIRST_LAYER; x <= LAST_LAYER; x++) {
          for(np = nodeTail[x]; np; np = np->prev) {
-            DrawPagerClient(pp, np);
+            AddPagerClient(pp, scratchCells, np);
          }
       }
 
+      /* Draw the background if nothing has been drawn yet. */
+      if(!pp->valid) {
+         JXSetForeground(display, rootGC, colors[COLOR_PAGER_BG]);
+         JXFillRectangle(display, buffer, rootGC, 0, 0, width, height);
+      }
+
+      /* Redraw desktops that changed. */
+      damaged = 0;
+      for(x = 0; x < settings.desktopCount; x++) {
+         if(!pp->valid || ComparePagerCells(&pp->cells[x], &scratchCells[x])) {
+            const PagerCellType temp = pp->cells[x];
+            pp->cells[x] = scratchCells[x];
+            pp->cells[x].gridValid = 0;
+            scratchCells[x] = temp;
+            DrawPagerCell(pp, x);
+            damaged = 1;
+         }
+      }
+      pp->valid = 1;
+#ifdef USE_COMPOSITE
+      SweepPagerThumbnails(pp);
+#endif
+      if(!damaged) {
+         continue;
+      }
+
       /* Draw the desktop dividers. */
       JXSetForeground(display, rootGC, colors[COLOR_PAGER_FG]);
       for(x = 1; x < settings.desktopHeight; x++) {
@@ -575,6 +718,228 @@ void UpdatePager(void)
 
 }
 
+/** Compare the contents of two pager cells.
+ * @return 0 if the same, 1 if different.
+ */
+char ComparePagerCells(const PagerCellType *a, const PagerCellType *b)
+{
+   unsigned int x;
+   if(a->active != b->active || a->count != b->count) {
+      return 1;
+   }
+   for(x = 0; x < a->count; x++) {
+      const PagerClientType *ac = &a->clients[x];
+      const PagerClientType *bc = &b->clients[x];
+      if(   ac->client != bc->client
+         || ac->x != bc->x || ac->y != bc->y
+         || ac->width != bc->width || ac->height != bc->height
+         || ac->color != bc->color) {
+         return 1;
+      }
+#ifdef USE_COMPOSITE
+      if(ac->thumbnail != bc->thumbnail || ac->serial != bc->serial) {
+         return 1;
+      }
+#endif
+   }
+   return 0;
+}
+
+/** Draw a desktop on the pager. */
+void DrawPagerCell(const PagerType *pp, unsigned int desktop)
+{
+
+   const PagerCellType *cell = &pp->cells[desktop];
+   const Pixmap buffer = pp->cp->pixmap;
+   const int offx = (desktop % settings.desktopWidth) * (pp->deskWidth + 1);
+   const int offy = (desktop / settings.desktopWidth) * (pp->deskHeight + 1);
+   unsigned int x;
+
+   /* Draw the background. */
+   if(cell->active) {
+      JXSetForeground(display, rootGC, colors[COLOR_PAGER_ACTIVE_BG]);
+   } else {
+      JXSetForeground(display, rootGC, colors[COLOR_PAGER_BG]);
+   }
+   JXFillRectangle(display, buffer, rootGC, offx, offy,
+                   pp->deskWidth, pp->deskHeight);
+
+   /* Draw the label. */
+   if(pp->labeled && labelHeight < pp->deskHeight) {
+      int textWidth;
+      const Pixmap label = GetPagerLabel(desktop, cell->active, &textWidth);
+      if(label != None && textWidth < pp->deskWidth) {
+         JXCopyArea(display, label, buffer, rootGC, 0, 0,
+                    textWidth, labelHeight,
+                    offx + (pp->deskWidth - textWidth) / 2,
+                    offy + (pp->deskHeight - labelHeight) / 2);
+      }
+   }
+
+   /* Draw the clients. */
+   for(x = 0; x < cell->count; x++) {
+
+      const PagerClientType *pc = &cell->clients[x];
+
+      /* Draw the client outline. */
+      JXSetForeground(display, rootGC, colors[COLOR_PAGER_OUTLINE]);
+      JXDrawRectangle(display, buffer, rootGC, offx + pc->x, offy + pc->y,
+                      pc->width, pc->height);
+
+      /* Fill the client if there's room. */
+      if(pc->width > 1 && pc->height > 1) {
+#ifdef USE_COMPOSITE
+         if(pc->thumbnail && pc->thumbnail->valid) {
+            JXCopyArea(display, pc->thumbnail->pixmap, buffer, rootGC,
+                       0, 0, pc->width - 1, pc->height - 1,
+                       offx + pc->x + 1, offy + pc->y + 1);
+            continue;
+         }
+#endif
+         JXSetForeground(display, rootGC, colors[pc->color]);
+         JXFillRectangle(display, buffer, rootGC,
+                         offx + pc->x + 1, offy + pc->y + 1,
+                         pc->width - 1, pc->height - 1);
+      }
+
+   }
+
+}
+
+/** Get the grid square containing a location on a desktop. */
+void GetPagerGridSquare(const PagerType *pp, int x, int y, int *gx, int *gy)
+{
+   *gx = (x * PAGER_GRID_SIZE) / Max(pp->deskWidth, 1);
+   *gy = (y * PAGER_GRID_SIZE) / Max(pp->deskHeight, 1);
+   *gx = Max(0, Min(*gx, PAGER_GRID_SIZE - 1));
+   *gy = Max(0, Min(*gy, PAGER_GRID_SIZE - 1));
+}
+
+/** Build the grid used to find clients on a desktop. */
+void BuildPagerGrid(const PagerType *pp, PagerCellType *cell)
+{
+
+   unsigned int next[PAGER_GRID_SIZE * PAGER_GRID_SIZE];
+   unsigned int i;
+   int gx0, gy0, gx1, gy1;
+   int gx, gy;
+
+   /* Count the clients in each grid square. */
+   memset(cell->gridStart, 0, sizeof(cell->gridStart));
+   for(i = 0; i < cell->count; i++) {
+      const PagerClientType *pc = &cell->clients[i];
+      GetPagerGridSquare(pp, pc->x, pc->y, &gx0, &gy0);
+      GetPagerGridSquare(pp, pc->x + pc->width, pc->y + pc->height,
+                         &gx1, &gy1);
+      for(gy = gy0; gy <= gy1; gy++) {
+         for(gx = gx0; gx <= gx1; gx++) {
+            cell->gridStart[gy * PAGER_GRID_SIZE + gx + 1] += 1;
+         }
+      }
+   }
+   for(i = 1; i <= PAGER_GRID_SIZE * PAGER_GRID_SIZE; i++) {
+      cell->gridStart[i] += cell->gridStart[i - 1];
+   }
+
+   /* Insert the clients from bottom to top. */
+   i = cell->gridStart[PAGER_GRID_SIZE * PAGER_GRID_SIZE];
+   if(i > cell->gridMax) {
+      if(cell->gridItems) {
+         Release(cell->gridItems);
+      }
+      cell->gridMax = i;
+      cell->gridItems = Allocate(i * sizeof(unsigned int));
+   }
+   memcpy(next, cell->gridStart, sizeof(next));
+   for(i = 0; i < cell->count; i++) {
+      const PagerClientType *pc = &cell->clients[i];
+      GetPagerGridSquare(pp, pc->x, pc->y, &gx0, &gy0);
+      GetPagerGridSquare(pp, pc->x + pc->width, pc->y + pc->height,
+                         &gx1, &gy1);
+      for(gy = gy0; gy <= gy1; gy++) {
+         for(gx = gx0; gx <= gx1; gx++) {
+            cell->gridItems[next[gy * PAGER_GRID_SIZE + gx]++] = i;
+         }
+      }
+   }
+   cell->gridValid = 1;
+
+}
+
+/** Find the top-most client at a location on a desktop of a pager. */
+ClientNode *FindPagerClient(PagerType *pp, int desktop, int x, int y)
+{
+
+   PagerCellType *cell;
+   unsigned int i;
+   int gx, gy;
+
+   if(!pp->valid || desktop < 0 || desktop >= settings.desktopCount) {
+      return NULL;
+   }
+
+   cell = &pp->cells[desktop];
+   if(!cell->gridValid) {
+      BuildPagerGrid(pp, cell);
+   }
+
+   GetPagerGridSquare(pp, x, y, &gx, &gy);
+   gx += gy * PAGER_GRID_SIZE;
+   for(i = cell->gridStart[gx + 1]; i > cell->gridStart[gx]; i--) {
+      const PagerClientType *pc = &cell->clients[cell->gridItems[i - 1]];
+      if(   x >= pc->x && x <= pc->x + pc->width
+         && y >= pc->y && y <= pc->y + pc->height) {
+         return pc->client;
+      }
+   }
+   return NULL;
+
+}
+
+/** Get the pre-rendered label for a desktop. */
+Pixmap GetPagerLabel(unsigned int desktop, char active, int *width)
+{
+
+   PagerLabelType *lp = &labels[desktop];
+   const char *name = GetDesktopName(desktop);
+   const int index = active ? 1 : 0;
+
+   /* Discard the label if the name changed. */
+   if(lp->name && strcmp(lp->name, name)) {
+      if(lp->pixmaps[0] != None) {
+         JXFreePixmap(display, lp->pixmaps[0]);
+         lp->pixmaps[0] = None;
+      }
+      if(lp->pixmaps[1] != None) {
+         JXFreePixmap(display, lp->pixmaps[1]);
+         lp->pixmaps[1] = None;
+      }
+      Release(lp->name);
+      lp->name = NULL;
+   }
+   if(!lp->name) {
+      lp->name = CopyString(name);
+      lp->width = GetStringWidth(FONT_PAGER, name);
+   }
+
+   *width = lp->width;
+   if(lp->pixmaps[index] == None && lp->width > 0) {
+      lp->pixmaps[index] = JXCreatePixmap(display, rootWindow, lp->width,
+                                          labelHeight, rootVisual.depth);
+      if(active) {
+         JXSetForeground(display, rootGC, colors[COLOR_PAGER_ACTIVE_BG]);
+      } else {
+         JXSetForeground(display, rootGC, colors[COLOR_PAGER_BG]);
+      }
+      JXFillRectangle(display, lp->pixmaps[index], rootGC, 0, 0,
+                      lp->width, labelHeight);
+      RenderString(&rootVisual, lp->pixmaps[index], FONT_PAGER,
+                   COLOR_PAGER_TEXT, 0, 0, lp->width, name);
+   }
+   return lp->pixmaps[index];
+
+}
+
 /** Signal pagers (for popups). */
 void SignalPager(const TimeType *now, int x, int y, Window w, void *data)
 {
@@ -596,13 +961,15 @@ void SignalPager(const TimeType *now, int x, int y, Window w, void *data)
    }
 }
 
-/** Draw a client on the pager. */
-void DrawPagerClient(const PagerType *pp, const ClientNode *np)
+/** Add a client to the contents of a pager. */
+void AddPagerClient(PagerType *pp, PagerCellType *cells,
+                    ClientNode *np)
 {
 
+   PagerCellType *cell;
+   PagerClientType *pc;
    int x, y;
    int width, height;
-   int offx, offy;
 
    /* Don't draw the client if it isn't mapped. */
    if(!(np->state.status & STAT_MAPPED)) {
@@ -612,17 +979,6 @@ void DrawPagerClient(const PagerType *pp, const ClientNode *np)
       return;
    }
 
-   /* Determine the desktop for the client. */
-   if(np->state.status & STAT_STICKY) {
-      offx = currentDesktop % settings.desktopWidth;
-      offy = currentDesktop / settings.desktopWidth;
-   } else {
-      offx = np->state.desktop % settings.desktopWidth;
-      offy = np->state.desktop / settings.desktopWidth;
-   }
-   offx *= pp->deskWidth + 1;
-   offy *= pp->deskHeight + 1;
-
    /* Determine the location and size of the client on the pager. */
    x = 1 + ((np->x * pp->scalex) >> 16);
    y = 1 + ((np->y * pp->scaley) >> 16);
@@ -650,30 +1006,236 @@ void DrawPagerClient(const PagerType *pp, const ClientNode *np)
       return;
    }
 
-   /* Move to the correct desktop on the pager. */
-   x += offx;
-   y += offy;
+   /* Determine the desktop for the client. */
+   if(np->state.status & STAT_STICKY) {
+      cell = &cells[currentDesktop];
+   } else {
+      cell = &cells[np->state.desktop];
+   }
 
-   /* Draw the client outline. */
-   JXSetForeground(display, rootGC, colors[COLOR_PAGER_OUTLINE]);
-   JXDrawRectangle(display, pp->cp->pixmap, rootGC, x, y, width, height);
+   if(cell->count == cell->max) {
+      if(cell->max) {
+         cell->max *= 2;
+         cell->clients = Reallocate(cell->clients,
+                                    cell->max * sizeof(PagerClientType));
+      } else {
+         cell->max = 8;
+         cell->clients = Allocate(cell->max * sizeof(PagerClientType));
+      }
+   }
+   pc = &cell->clients[cell->count];
+   cell->count += 1;
+
+   pc->client = np;
+   pc->x = x;
+   pc->y = y;
+   pc->width = width;
+   pc->height = height;
+   if((np->state.status & STAT_ACTIVE)
+      && (np->state.desktop == currentDesktop
+      || (np->state.status & STAT_STICKY))) {
+      pc->color = COLOR_PAGER_ACTIVE_FG;
+   } else if(np->state.status & STAT_FLASH) {
+      pc->color = COLOR_PAGER_ACTIVE_FG;
+   } else {
+      pc->color = COLOR_PAGER_FG;
+   }
+
+#ifdef USE_COMPOSITE
+   pc->thumbnail = NULL;
+   pc->serial = 0;
+   /* Shaded clients have no contents to show. */
+   if(   pp->thumbnails && haveComposite && width > 1 && height > 1
+      && !(np->state.status & STAT_SHADED)) {
+      pc->thumbnail = GetPagerThumbnail(pp, np, width - 1, height - 1);
+      if(pc->thumbnail) {
+         pc->serial = pc->thumbnail->serial;
+      }
+   }
+#endif
+
+}
+
+#ifdef USE_COMPOSITE
+
+/** Get the thumbnail for a client, refreshing it if needed. */
+PagerThumbnailType *GetPagerThumbnail(PagerType *pp, const ClientNode *np,
+                                      int width, int height)
+{
 
-   /* Fill the client if there's room. */
-   if(width > 1 && height > 1) {
-      ColorType fillColor;
-      if((np->state.status & STAT_ACTIVE)
-         && (np->state.desktop == currentDesktop
-         || (np->state.status & STAT_STICKY))) {
-         fillColor = COLOR_PAGER_ACTIVE_FG;
-      } else if(np->state.status & STAT_FLASH) {
-         fillColor = COLOR_PAGER_ACTIVE_FG;
+   PagerThumbnailType *tp;
+
+   for(tp = pp->thumbnailList; tp; tp = tp->next) {
+      if(tp->window == np->window) {
+         break;
+      }
+   }
+
+   if(!tp) {
+
+      XRenderPictFormat *format;
+      XRenderPictureAttributes pa;
+
+      format = JXRenderFindVisualFormat(display, np->visual.visual);
+      if(JUNLIKELY(!format)) {
+         return NULL;
+      }
+
+      tp = Allocate(sizeof(PagerThumbnailType));
+      tp->window = np->window;
+      tp->damage = JXDamageCreate(display, np->window,
+                                  XDamageReportNonEmpty);
+      pa.subwindow_mode = IncludeInferiors;
+      tp->source = JXRenderCreatePicture(display, np->window, format,
+                                         CPSubwindowMode, &pa);
+      JXRenderSetPictureFilter(display, tp->source, FilterBilinear, NULL, 0);
+      tp->pixmap = None;
+      tp->picture = None;
+      tp->width = 0;
+      tp->height = 0;
+      tp->valid = 0;
+      tp->dirty = 1;
+      tp->next = pp->thumbnailList;
+      pp->thumbnailList = tp;
+
+   }
+   tp->used = 1;
+
+   /* Resize the thumbnail if the size on the pager changed. */
+   if(tp->width != width || tp->height != height) {
+      if(tp->pixmap != None) {
+         JXRenderFreePicture(display, tp->picture);
+         JXFreePixmap(display, tp->pixmap);
+      }
+      tp->width = width;
+      tp->height = height;
+      tp->pixmap = JXCreatePixmap(display, rootWindow, width, height,
+                                  rootVisual.depth);
+      tp->picture = JXRenderCreatePicture(display, tp->pixmap,
+         JXRenderFindVisualFormat(display, rootVisual.visual), 0, NULL);
+      tp->valid = 0;
+      tp->dirty = 1;
+      thumbnailSerial += 1;
+      tp->serial = thumbnailSerial;
+   }
+
+   /* Refresh the contents if the window is visible.
+    * Windows on other desktops keep their last contents. */
+   if(tp->dirty && !(np->state.status & STAT_HIDDEN)) {
+      if(pp->canRefresh) {
+         RefreshPagerThumbnail(tp, np);
       } else {
-         fillColor = COLOR_PAGER_FG;
+         pp->refreshPending = 1;
       }
-      JXSetForeground(display, rootGC, colors[fillColor]);
-      JXFillRectangle(display, pp->cp->pixmap, rootGC, x + 1, y + 1,
-                      width - 1, height - 1);
    }
 
+   return tp;
+
+}
+
+/** Render the scaled contents of a window to its thumbnail. */
+void RefreshPagerThumbnail(PagerThumbnailType *tp, const ClientNode *np)
+{
+
+   XTransform xform;
+
+   JXDamageSubtract(display, tp->damage, None, None);
+
+   memset(&xform, 0, sizeof(xform));
+   xform.matrix[0][0] = XDoubleToFixed((double)np->width / tp->width);
+   xform.matrix[1][1] = XDoubleToFixed((double)np->height / tp->height);
+   xform.matrix[2][2] = XDoubleToFixed(1.0);
+   JXRenderSetPictureTransform(display, tp->source, &xform);
+   JXRenderComposite(display, PictOpSrc, tp->source, None, tp->picture,
+                     0, 0, 0, 0, 0, 0, tp->width, tp->height);
+
+   tp->valid = 1;
+   tp->dirty = 0;
+   thumbnailSerial += 1;
+   tp->serial = thumbnailSerial;
+
+}
+
+/** Release a window thumbnail. */
+void DestroyPagerThumbnail(PagerThumbnailType *tp)
+{
+   if(tp->window != None) {
+      JXDamageDestroy(display, tp->damage);
+      JXRenderFreePicture(display, tp->source);
+   }
+   if(tp->pixmap != None) {
+      JXRenderFreePicture(display, tp->picture);
+      JXFreePixmap(display, tp->pixmap);
+   }
+   Release(tp);
+}
+
+/** Release thumbnails for windows that are no longer shown. */
+void SweepPagerThumbnails(PagerType *pp)
+{
+   PagerThumbnailType **tpp = &pp->thumbnailList;
+   while(*tpp) {
+      PagerThumbnailType *tp = *tpp;
+      if(tp->used) {
+         tp->used = 0;
+         tpp = &tp->next;
+      } else {
+         *tpp = tp->next;
+         DestroyPagerThumbnail(tp);
+      }
+   }
+}
+
+/** Release the thumbnail resources for a window.
+ * The damage and picture of a destroyed window were freed by the server
+ * along with the window. The thumbnail itself is released on the next
+ * sweep since pager cells may still refer to it.
+ */
+void RemovePagerWindow(Window w, char destroyed)
+{
+   PagerType *pp;
+   PagerThumbnailType *tp;
+   for(pp = pagers; pp; pp = pp->next) {
+      for(tp = pp->thumbnailList; tp; tp = tp->next) {
+         if(tp->window == w) {
+            if(!destroyed) {
+               JXDamageDestroy(display, tp->damage);
+               JXRenderFreePicture(display, tp->source);
+            }
+            tp->window = None;
+            tp->damage = None;
+            tp->source = None;
+            break;
+         }
+      }
+   }
+}
+
+/** Handle a damage event for pager thumbnails. */
+void HandlePagerDamage(const XDamageNotifyEvent *event)
+{
+   PagerType *pp;
+   PagerThumbnailType *tp;
+   for(pp = pagers; pp; pp = pp->next) {
+      for(tp = pp->thumbnailList; tp; tp = tp->next) {
+         if(tp->damage == event->damage) {
+            tp->dirty = 1;
+            pp->refreshPending = 1;
+            break;
+         }
+      }
+   }
+}
+
+/** Callback to refresh pager thumbnails. */
+void SignalPagerThumbnails(const TimeType *now, int x, int y, Window w,
+                           void *data)
+{
+   PagerType *pp = (PagerType*)data;
+   if(pp->refreshPending) {
+      pp->refreshPending = 0;
+      UpdatePager();
+   }
 }
 
+#endif /* USE_COMPOSITE */
@@ -21,12 +21,29 @@ void DestroyPager(void);
 
 /** Create a pager tray component.
  * @param labeled Set to label the pager.
+ * @param thumbnails Set to draw window thumbnails.
  * @return A new pager tray component.
  */
-struct TrayComponentType *CreatePager(char labeled);
+struct TrayComponentType *CreatePager(char labeled, char thumbnails);
 
 /** Update pagers. */
 void UpdatePager(void);
 
+#ifdef USE_COMPOSITE
+/** Handle a damage event for pager thumbnails.
+ * @param event The damage event.
+ */
+void HandlePagerDamage(const XDamageNotifyEvent *event);
+
+/** Release the thumbnail resources for a window.
+ * This should be called before a client window is destroyed.
+ * @param w The client window.
+ * @param destroyed Set if the window has already been destroyed.
+ */
+void RemovePagerWindow(Window w, char destroyed);
+#else
+#define RemovePagerWindow( a, b ) (void)(0)
+#endif
+
 #endif /* PAGER_H */
 
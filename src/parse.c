@@ -32,6 +32,7 @@
 #include "spacer.h"
 #include "desktop.h"
 #include "border.h"
+#include "dynamic.h"
 
 /** Mapping of key names to key types.
  * Note that this mapping must be sorted.
@@ -104,6 +105,7 @@ static const StringMappingType OPTION_MAP[] = {
    { "notitle",            OPTION_NOTITLE       },
    { "noturgent",          OPTION_NOTURGENT     },
    { "pignore",            OPTION_PIGNORE       },
+   { "smart",              OPTION_SMART         },
    { "sticky",             OPTION_STICKY        },
    { "tiled",              OPTION_TILED         },
    { "title",              OPTION_TITLE         },
@@ -121,6 +123,8 @@ static const char *X_ATTRIBUTE = "x";
 static const char *Y_ATTRIBUTE = "y";
 static const char *WIDTH_ATTRIBUTE = "width";
 static const char *HEIGHT_ATTRIBUTE = "height";
+static const char *TTL_ATTRIBUTE = "ttl";
+static const char *THUMBNAILS_ATTRIBUTE = "thumbnails";
 
 static const char *FALSE_VALUE = "false";
 static const char *TRUE_VALUE = "true";
@@ -408,6 +412,11 @@ void ParseMoveMode(const TokenNode *tp)
       settings.desktopDelay = ParseUnsigned(tp, str);
    }
 
+   str = FindAttribute(tp->attributes, "rate");
+   if(str) {
+      settings.moveRate = ParseUnsigned(tp, str);
+   }
+
    settings.moveStatusType = ParseStatusWindowType(tp);
    settings.moveMode = ParseTokenValue(mapping, ARRAY_LENGTH(mapping), tp,
                                        settings.moveMode);
@@ -638,6 +647,10 @@ MenuItem *ParseMenuItem(const TokenNode *start, Menu *menu,
          case TOK_INCLUDE:
             last->action.type = MA_DYNAMIC;
             last->action.data.str = CopyString(start->value);
+            value = FindAttribute(start->attributes, TTL_ATTRIBUTE);
+            if(value && start->value) {
+               SetDynamicMenuTTL(start->value, ParseUnsigned(start, value));
+            }
             break;
          default:
             break;
@@ -702,7 +715,7 @@ MenuItem *ParseMenuItem(const TokenNode *start, Menu *menu,
 }
 
 /** Parse a dynamic menu (called from menu code). */
-Menu *ParseDynamicMenu(const char *command)
+Menu *ParseDynamicMenu(const char *command, char wait)
 {
    FILE *fd;
    char *path;
@@ -713,17 +726,10 @@ Menu *ParseDynamicMenu(const char *command)
    buffer = NULL;
    if(!strncmp(command, "exec:", 5)) {
 
-      path = Allocate(strlen(command) - 5 + 1);
-      strcpy(path, command + 5);
-      ExpandPath(&path);
-
-      fd = popen(path, "r");
-      if(JLIKELY(fd)) {
-         buffer = ReadFile(fd);
-         pclose(fd);
-      } else {
-         ParseError(NULL, "could not execute included program: %s", path);
-      }
+      /* The program is run in the background and its last output
+       * is returned (if available). */
+      path = NULL;
+      buffer = CopyString(GetDynamicMenuOutput(command, wait));
 
    } else {
 
@@ -741,13 +747,17 @@ Menu *ParseDynamicMenu(const char *command)
    }
 
    if(!buffer) {
-      Release(path);
+      if(path) {
+         Release(path);
+      }
       return NULL;
    }
 
-   start = Tokenize(buffer, path);
+   start = Tokenize(buffer, path ? path : command);
    Release(buffer);
-   Release(path);
+   if(path) {
+      Release(path);
+   }
 
    if(JUNLIKELY(!start || start->type != TOK_JWM)) {
       ParseError(NULL, "invalid include: %s", command);
@@ -1188,6 +1198,7 @@ void ParsePager(const TokenNode *tp, TrayType *tray)
    TrayComponentType *cp;
    const char *temp;
    int labeled;
+   int thumbnails;
 
    Assert(tp);
    Assert(tray);
@@ -1197,7 +1208,12 @@ void ParsePager(const TokenNode *tp, TrayType *tray)
    if(temp && !strcmp(temp, TRUE_VALUE)) {
       labeled = 1;
    }
-   cp = CreatePager(labeled);
+   thumbnails = 0;
+   temp = FindAttribute(tp->attributes, THUMBNAILS_ATTRIBUTE);
+   if(temp && !strcmp(temp, TRUE_VALUE)) {
+      thumbnails = 1;
+   }
+   cp = CreatePager(labeled, thumbnails);
    AddTrayComponent(tray, cp);
 
 }
@@ -1220,6 +1236,11 @@ void ParseTaskList(const TokenNode *tp, TrayType *tray)
       SetMaxTaskBarItemWidth(cp, temp);
    }
 
+   temp = FindAttribute(tp->attributes, "group");
+   if(temp && !strcmp(temp, TRUE_VALUE)) {
+      SetTaskBarGrouped(cp, 1);
+   }
+
 }
 
 /** Parse a swallow tray component. */
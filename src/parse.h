@@ -19,9 +19,10 @@ void ParseConfig(const char *fileName);
 
 /** Parse a dynamic menu.
  * @param command The command to generate the menu.
+ * @param wait Set to give an "exec:" command time to finish.
  * @return The menu.
  */
-struct Menu *ParseDynamicMenu(const char *command);
+struct Menu *ParseDynamicMenu(const char *command, char wait);
 
 #endif /* PARSE_H */
 
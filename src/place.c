@@ -24,6 +24,44 @@ typedef struct Strut {
 
 static Strut *struts = NULL;
 
+/* Cached work areas: (screenCount + 1) x desktopCount x LAYER_COUNT.
+ * The last "screen" is the whole root window. Entries are computed on
+ * demand and cleared when struts or trays change. */
+static BoundingBox *workareas = NULL;
+static char *workareaValid = NULL;
+static int workareaCount;
+
+/** List of free rectangles used for tiled placement. */
+typedef struct FreeList {
+   BoundingBox *rects;  /**< Maximal free rectangles. */
+   int count;           /**< Number of rectangles. */
+   int max;             /**< Space allocated for rectangles. */
+} FreeList;
+
+/** Free space for tiled placement on a desktop and layer of a screen. */
+typedef struct FreeSpace {
+   FreeList list;             /**< Free rectangles. */
+   BoundingBox area;          /**< Work area the list was built for. */
+   const ClientNode **clients;   /**< Clients removed from the area. */
+   BoundingBox *used;         /**< Area removed for each client. */
+   int clientCount;           /**< Number of clients removed. */
+   int clientMax;             /**< Space allocated for clients. */
+   char valid;                /**< Set if the list has been built. */
+} FreeSpace;
+
+/* Free space: screenCount x desktopCount x LAYER_COUNT.
+ * Entries are built on demand. Clients that change are queued and the
+ * area they use is updated before the next query. */
+static FreeSpace *freeSpaces = NULL;
+static int freeSpaceCount;
+static int validFreeSpaces;
+static const ClientNode **changedClients = NULL;
+static int changedCount;
+static int changedMax;
+
+/** Maximum number of grid cells in each direction for smart placement. */
+#define SMART_GRID_SIZE 64
+
 /* desktopCount x screenCount */
 /* Note that we assume x and y are 0 based for all screens here. */
 static int *cascadeOffsets = NULL;
@@ -31,15 +69,37 @@ static int *cascadeOffsets = NULL;
 static char DoRemoveClientStrut(ClientNode *np);
 static void InsertStrut(const BoundingBox *box, ClientNode *np);
 static void CenterClient(const BoundingBox *box, ClientNode *np);
-static int IntComparator(const void *a, const void *b);
-static char TryTileClient(const BoundingBox *box, ClientNode *np,
-                          int x, int y);
-static char TileClient(const BoundingBox *box, ClientNode *np);
+static char TileClient(const ScreenType *sp, const BoundingBox *box,
+                       ClientNode *np);
+static void InsertFreeRect(FreeList *list, const BoundingBox *box);
+static void SubtractFreeRect(FreeList *list, const BoundingBox *used);
+static void AddFreeRect(FreeSpace *fp, const BoundingBox *freed);
+static void CreateFreeSpace(FreeSpace *fp, const BoundingBox *box,
+                            unsigned int desktop, unsigned int layer,
+                            const ClientNode *np);
+static void DestroyFreeSpace(FreeSpace *fp);
+static void FlushFreeSpace(void);
+static void UpdateFreeClient(FreeSpace *fp, unsigned int desktop,
+                             unsigned int layer, const ClientNode *np);
+static void InsertFreeClient(FreeSpace *fp, const ClientNode *np,
+                             const BoundingBox *used);
+static void RemoveFreeClient(FreeSpace *fp, int index);
+static char GetUsedArea(const ClientNode *np, unsigned int desktop,
+                        BoundingBox *used);
+static char IsInside(const BoundingBox *inner, const BoundingBox *outer);
+static char IsOverlapping(const BoundingBox *a, const BoundingBox *b);
 static void CascadeClient(const BoundingBox *box, ClientNode *np);
+static void SmartClient(const BoundingBox *box, ClientNode *np);
 
-static void SubtractStrutBounds(BoundingBox *box, const ClientNode *np);
+static void SubtractStrutBounds(BoundingBox *box, const ClientNode *np,
+                                unsigned int desktop);
 static void SubtractBounds(const BoundingBox *src, BoundingBox *dest);
-static void SetWorkarea(void);
+static void GetWorkarea(const ScreenType *sp, unsigned int desktop,
+                        unsigned int layer, const ClientNode *np,
+                        BoundingBox *box);
+static void ComputeWorkarea(const ScreenType *sp, unsigned int desktop,
+                            unsigned int layer, const ClientNode *np,
+                            BoundingBox *box);
 
 /** Startup placement. */
 void StartupPlacement(void)
@@ -55,6 +115,18 @@ void StartupPlacement(void)
       cascadeOffsets[x] = settings.borderWidth + settings.titleHeight;
    }
 
+   workareaCount = (GetScreenCount() + 1) * settings.desktopCount
+                 * LAYER_COUNT;
+   workareas = Allocate(workareaCount * sizeof(BoundingBox));
+   workareaValid = Allocate(workareaCount);
+
+   freeSpaceCount = GetScreenCount() * settings.desktopCount * LAYER_COUNT;
+   freeSpaces = Allocate(freeSpaceCount * sizeof(FreeSpace));
+   memset(freeSpaces, 0, freeSpaceCount * sizeof(FreeSpace));
+   validFreeSpaces = 0;
+   changedCount = 0;
+   changedMax = 0;
+
    SetWorkarea();
 
 }
@@ -64,8 +136,23 @@ void ShutdownPlacement(void)
 {
 
    Strut *sp;
+   int x;
 
    Release(cascadeOffsets);
+   Release(workareas);
+   Release(workareaValid);
+   workareas = NULL;
+   workareaValid = NULL;
+
+   for(x = 0; x < freeSpaceCount; x++) {
+      DestroyFreeSpace(&freeSpaces[x]);
+   }
+   Release(freeSpaces);
+   freeSpaces = NULL;
+   if(changedClients) {
+      Release(changedClients);
+      changedClients = NULL;
+   }
 
    while(struts) {
       sp = struts->next;
@@ -88,6 +175,10 @@ char DoRemoveClientStrut(ClientNode *np)
 {
    char updated = 0;
    Strut **spp = &struts;
+   if(!np->hasStruts) {
+      return 0;
+   }
+   np->hasStruts = 0;
    while(*spp) {
       Strut *sp = *spp;
       if(sp->client == np) {
@@ -111,6 +202,7 @@ void InsertStrut(const BoundingBox *box, ClientNode *np)
       sp->box = *box;
       sp->next = struts;
       struts = sp;
+      np->hasStruts = 1;
    }
 }
 
@@ -264,6 +356,14 @@ void ReadClientStrut(ClientNode *np)
 
 }
 
+/** Update the work area after the desktop of a client changes. */
+void UpdateClientStrut(const ClientNode *np)
+{
+   if(np->hasStruts) {
+      SetWorkarea();
+   }
+}
+
 /** Get the screen bounds. */
 void GetScreenBounds(const ScreenType *sp, BoundingBox *box)
 {
@@ -374,7 +474,8 @@ void SubtractTrayBounds(const TrayType *tp, BoundingBox *box,
 }
 
 /** Remove struts from the bounding box. */
-void SubtractStrutBounds(BoundingBox *box, const ClientNode *np)
+void SubtractStrutBounds(BoundingBox *box, const ClientNode *np,
+                         unsigned int desktop)
 {
 
    Strut *sp;
@@ -384,7 +485,7 @@ void SubtractStrutBounds(BoundingBox *box, const ClientNode *np)
       if(np != NULL && sp->client == np) {
          continue;
       }
-      if(sp->client->state.desktop == currentDesktop
+      if(sp->client->state.desktop == desktop
          || (sp->client->state.status & STAT_STICKY)) {
          last = *box;
          SubtractBounds(&sp->box, box);
@@ -406,159 +507,430 @@ void CenterClient(const BoundingBox *box, ClientNode *np)
    ConstrainPosition(np);
 }
 
-/** Compare two integers. */
-int IntComparator(const void *a, const void *b)
+/** Tiled placement.
+ * The free space is kept as a list of maximal empty rectangles. The
+ * window fits at the top-left corner of any free rectangle large enough
+ * to hold it.
+ */
+char TileClient(const ScreenType *sp, const BoundingBox *box,
+                ClientNode *np)
 {
-   const int ia = *(const long*)a;
-   const int ib = *(const long*)b;
-   return ia - ib;
+
+   FreeSpace *fp;
+   const BoundingBox *best;
+   int north, south, east, west;
+   int width, height;
+   int x;
+
+   /* Get the size of the client, including the border. */
+   GetBorderSize(&np->state, &north, &south, &east, &west);
+   np->x = box->x + west;
+   np->y = box->y + north;
+   ConstrainSize(np);
+   width = np->width + east + west;
+   height = np->height + north + south;
+
+   /* Bring the free space up to date. */
+   FlushFreeSpace();
+   x = (sp->index * settings.desktopCount + currentDesktop) * LAYER_COUNT
+     + np->state.layer;
+   fp = &freeSpaces[x];
+   if(   !fp->valid
+      || fp->area.x != box->x || fp->area.y != box->y
+      || fp->area.width != box->width || fp->area.height != box->height) {
+      CreateFreeSpace(fp, box, currentDesktop, np->state.layer, np);
+   }
+
+   /* Use the left-most, then top-most, position that fits. */
+   best = NULL;
+   for(x = 0; x < fp->list.count; x++) {
+      const BoundingBox *rp = &fp->list.rects[x];
+      if(rp->width < width || rp->height < height) {
+         continue;
+      }
+      if(!best || rp->x < best->x || (rp->x == best->x && rp->y < best->y)) {
+         best = rp;
+      }
+   }
+
+   if(best) {
+      np->x = best->x + west;
+      np->y = best->y + north;
+      ConstrainPosition(np);
+   }
+
+   /* Tiled placement failed if there was no room. */
+   return best != NULL;
+
 }
 
-/** Attempt to place the client at the specified coordinates. */
-char TryTileClient(const BoundingBox *box, ClientNode *np, int x, int y)
+/** Build the free space for a work area.
+ * Visible clients at or above the layer, other than np, are removed.
+ */
+void CreateFreeSpace(FreeSpace *fp, const BoundingBox *box,
+                     unsigned int desktop, unsigned int layer,
+                     const ClientNode *np)
 {
+
    const ClientNode *tp;
-   int layer;
+   BoundingBox used;
+   unsigned int x;
+
+   DestroyFreeSpace(fp);
+   fp->list.count = 0;
+   fp->list.max = 16;
+   fp->list.rects = Allocate(sizeof(BoundingBox) * fp->list.max);
+   fp->area = *box;
+   fp->valid = 1;
+   validFreeSpaces += 1;
+
+   /* Start with the whole area free. */
+   InsertFreeRect(&fp->list, box);
+
+   for(x = layer; x < LAYER_COUNT; x++) {
+      for(tp = nodes[x]; tp; tp = tp->next) {
+         if(tp != np && GetUsedArea(tp, desktop, &used)) {
+            InsertFreeClient(fp, tp, &used);
+            SubtractFreeRect(&fp->list, &used);
+         }
+      }
+   }
+
+}
+
+/** Release free space. */
+void DestroyFreeSpace(FreeSpace *fp)
+{
+   if(fp->valid) {
+      Release(fp->list.rects);
+      if(fp->clients) {
+         Release(fp->clients);
+         Release(fp->used);
+      }
+      memset(fp, 0, sizeof(FreeSpace));
+      validFreeSpaces -= 1;
+   }
+}
+
+/** Get the area used by a client on a desktop.
+ * @return 1 if the client is mapped on the desktop, 0 otherwise.
+ */
+char GetUsedArea(const ClientNode *np, unsigned int desktop,
+                 BoundingBox *used)
+{
+
    int north, south, east, west;
-   int x1, x2, y1, y2;
-   int ox1, ox2, oy1, oy2;
 
-   /* Set the client position. */
+   if(!(np->state.status & STAT_MAPPED)) {
+      return 0;
+   }
+   if(np->state.desktop != desktop) {
+      if(!(np->state.status & STAT_STICKY)) {
+         return 0;
+      }
+   }
+
    GetBorderSize(&np->state, &north, &south, &east, &west);
-   np->x = x + west;
-   np->y = y + north;
-   ConstrainSize(np);
-   ConstrainPosition(np);
+   used->x = np->x - west;
+   used->y = np->y - north;
+   used->width = np->width + east + west;
+   used->height = np->height + north + south;
+   return 1;
 
-   /* Get the client boundaries. */
-   x1 = np->x - west;
-   x2 = np->x + np->width + east;
-   y1 = np->y - north;
-   y2 = np->y + np->height + south;
+}
 
-   /* Loop over each client. */
-   for(layer = np->state.layer; layer < LAYER_COUNT; layer++) {
-      for(tp = nodes[layer]; tp; tp = tp->next) {
+/** Update the free space for clients that changed. */
+void FlushFreeSpace(void)
+{
 
-         /* Skip clients that aren't visible. */
-         if(tp->state.desktop != currentDesktop) {
-            if(!(tp->state.status & STAT_STICKY)) {
-               continue;
-            }
-         }
-         if(!(tp->state.status & STAT_MAPPED)) {
-            continue;
-         }
-         if(tp == np) {
-            continue;
+   int i, x;
+
+   for(i = 0; i < changedCount; i++) {
+      for(x = 0; x < freeSpaceCount; x++) {
+         if(freeSpaces[x].valid) {
+            const unsigned int layer = x % LAYER_COUNT;
+            const unsigned int desktop
+               = (x / LAYER_COUNT) % settings.desktopCount;
+            UpdateFreeClient(&freeSpaces[x], desktop, layer,
+                             changedClients[i]);
          }
+      }
+   }
+   changedCount = 0;
 
-         /* Get the boundaries of the other client. */
-         GetBorderSize(&tp->state, &north, &south, &east, &west);
-         ox1 = tp->x - west;
-         ox2 = tp->x + tp->width + east;
-         oy1 = tp->y - north;
-         oy2 = tp->y + tp->height + south;
+}
 
-         /* Check for an overlap. */
-         if(x2 <= ox1 || x1 >= ox2) {
-            continue;
-         }
-         if(y2 <= oy1 || y1 >= oy2) {
-            continue;
-         }
-         return 0;
+/** Update the area used by a client in free space.
+ * The old area is returned to the free space and the new area is
+ * removed from it.
+ */
+void UpdateFreeClient(FreeSpace *fp, unsigned int desktop,
+                      unsigned int layer, const ClientNode *np)
+{
+
+   BoundingBox used;
+   char visible;
+   int x;
 
+   visible = np->state.layer >= layer && GetUsedArea(np, desktop, &used);
+   for(x = 0; x < fp->clientCount; x++) {
+      if(fp->clients[x] == np) {
+         const BoundingBox old = fp->used[x];
+         if(   visible && old.x == used.x && old.y == used.y
+            && old.width == used.width && old.height == used.height) {
+            return;
+         }
+         RemoveFreeClient(fp, x);
+         AddFreeRect(fp, &old);
+         break;
       }
    }
 
-   /* No client overlaps this position. */
-   return 1;
+   if(visible) {
+      InsertFreeClient(fp, np, &used);
+      SubtractFreeRect(&fp->list, &used);
+   }
 
 }
 
-/** Tiled placement. */
-char TileClient(const BoundingBox *box, ClientNode *np)
+/** Record the area removed for a client. */
+void InsertFreeClient(FreeSpace *fp, const ClientNode *np,
+                      const BoundingBox *used)
 {
+   if(fp->clientCount == fp->clientMax) {
+      fp->clientMax = fp->clientMax ? fp->clientMax * 2 : 16;
+      fp->clients = Reallocate(fp->clients,
+                               sizeof(ClientNode*) * fp->clientMax);
+      fp->used = Reallocate(fp->used, sizeof(BoundingBox) * fp->clientMax);
+   }
+   fp->clients[fp->clientCount] = np;
+   fp->used[fp->clientCount] = *used;
+   fp->clientCount += 1;
+}
 
-   const ClientNode *tp;
-   int layer;
-   int north, south, east, west;
-   int i, j;
+/** Remove the record of the area removed for a client. */
+void RemoveFreeClient(FreeSpace *fp, int index)
+{
+   fp->clientCount -= 1;
+   fp->clients[index] = fp->clients[fp->clientCount];
+   fp->used[index] = fp->used[fp->clientCount];
+}
+
+/** Return an area that is no longer used to the free space.
+ * The maximal rectangles overlapping the area are found by subtracting
+ * the remaining clients from the work area, keeping only rectangles that
+ * overlap the area. Existing rectangles that grow into the area are
+ * inside one of these and are dropped.
+ */
+void AddFreeRect(FreeSpace *fp, const BoundingBox *freed)
+{
+
+   FreeList part;
    int count;
-   int *xs;
-   int *ys;
+   int x, y;
 
-   /* Determine how much space to allocate. */
-   count = 1;
-   for(layer = np->state.layer; layer < LAYER_COUNT; layer++) {
-      for(tp = nodes[layer]; tp; tp = tp->next) {
-         if(tp->state.desktop != currentDesktop) {
-            if(!(tp->state.status & STAT_STICKY)) {
-               continue;
-            }
-         }
-         if(!(tp->state.status & STAT_MAPPED)) {
-            continue;
+   if(!IsOverlapping(freed, &fp->area)) {
+      return;
+   }
+
+   part.count = 0;
+   part.max = 16;
+   part.rects = Allocate(sizeof(BoundingBox) * part.max);
+   InsertFreeRect(&part, &fp->area);
+   for(x = 0; x < fp->clientCount && part.count > 0; x++) {
+      SubtractFreeRect(&part, &fp->used[x]);
+      y = 0;
+      while(y < part.count) {
+         if(IsOverlapping(&part.rects[y], freed)) {
+            y += 1;
+         } else {
+            part.count -= 1;
+            part.rects[y] = part.rects[part.count];
          }
-         if(tp == np) {
-            continue;
+      }
+   }
+
+   /* Drop existing rectangles that are inside a new one. */
+   count = fp->list.count;
+   for(x = 0; x < part.count; x++) {
+      InsertFreeRect(&fp->list, &part.rects[x]);
+   }
+   for(x = 0; x < count; x++) {
+      for(y = count; y < fp->list.count; y++) {
+         if(IsInside(&fp->list.rects[x], &fp->list.rects[y])) {
+            fp->list.rects[x].width = 0;
+            break;
          }
-         count += 2;
       }
    }
+   y = 0;
+   for(x = 0; x < fp->list.count; x++) {
+      if(fp->list.rects[x].width > 0) {
+         fp->list.rects[y] = fp->list.rects[x];
+         y += 1;
+      }
+   }
+   fp->list.count = y;
 
-   /* Allocate space for the points. */
-   xs = AllocateStack(sizeof(int) * count);
-   ys = AllocateStack(sizeof(int) * count);
+   Release(part.rects);
 
-   /* Insert points. */
-   xs[0] = box->x;
-   ys[0] = box->y;
-   count = 1;
-   for(layer = np->state.layer; layer < LAYER_COUNT; layer++) {
-      for(tp = nodes[layer]; tp; tp = tp->next) {
-         if(tp->state.desktop != currentDesktop) {
-            if(!(tp->state.status & STAT_STICKY)) {
-               continue;
-            }
+}
+
+/** Queue a client whose area changed. */
+void UpdateFreeSpace(const ClientNode *np)
+{
+
+   int x;
+
+   if(validFreeSpaces == 0) {
+      return;
+   }
+   for(x = 0; x < changedCount; x++) {
+      if(changedClients[x] == np) {
+         return;
+      }
+   }
+   if(changedCount == changedMax) {
+      changedMax = changedMax ? changedMax * 2 : 16;
+      changedClients = Reallocate(changedClients,
+                                  sizeof(ClientNode*) * changedMax);
+   }
+   changedClients[changedCount] = np;
+   changedCount += 1;
+
+}
+
+/** Return the area used by a client that is being removed. */
+void RemoveFreeSpaceClient(const ClientNode *np)
+{
+
+   int i, x;
+
+   for(x = 0; x < changedCount; x++) {
+      if(changedClients[x] == np) {
+         changedCount -= 1;
+         changedClients[x] = changedClients[changedCount];
+         break;
+      }
+   }
+
+   for(x = 0; x < freeSpaceCount; x++) {
+      FreeSpace *fp = &freeSpaces[x];
+      for(i = 0; i < fp->clientCount; i++) {
+         if(fp->clients[i] == np) {
+            const BoundingBox old = fp->used[i];
+            RemoveFreeClient(fp, i);
+            AddFreeRect(fp, &old);
+            break;
          }
-         if(!(tp->state.status & STAT_MAPPED)) {
+      }
+   }
+
+}
+
+/** Add a rectangle to a list of free rectangles. */
+void InsertFreeRect(FreeList *list, const BoundingBox *box)
+{
+   if(list->count == list->max) {
+      list->max *= 2;
+      list->rects = Reallocate(list->rects, sizeof(BoundingBox) * list->max);
+   }
+   list->rects[list->count] = *box;
+   list->count += 1;
+}
+
+/** Remove the area covered by a window from a list of free rectangles.
+ * Each free rectangle overlapping the window is replaced by the (up to
+ * four) maximal rectangles around the window. Since no rectangle in the
+ * list is inside another, only the new pieces need to be checked
+ * against the rest of the list.
+ */
+void SubtractFreeRect(FreeList *list, const BoundingBox *used)
+{
+
+   const int count = list->count;
+   int x, y;
+
+   for(x = 0; x < count; x++) {
+
+      const BoundingBox f = list->rects[x];
+      BoundingBox piece;
+
+      if(used->x >= f.x + f.width || used->x + used->width <= f.x) {
+         continue;
+      }
+      if(used->y >= f.y + f.height || used->y + used->height <= f.y) {
+         continue;
+      }
+
+      list->rects[x].width = 0;
+      if(used->x > f.x) {
+         piece = f;
+         piece.width = used->x - f.x;
+         InsertFreeRect(list, &piece);
+      }
+      if(used->x + used->width < f.x + f.width) {
+         piece = f;
+         piece.x = used->x + used->width;
+         piece.width = f.x + f.width - piece.x;
+         InsertFreeRect(list, &piece);
+      }
+      if(used->y > f.y) {
+         piece = f;
+         piece.height = used->y - f.y;
+         InsertFreeRect(list, &piece);
+      }
+      if(used->y + used->height < f.y + f.height) {
+         piece = f;
+         piece.y = used->y + used->height;
+         piece.height = f.y + f.height - piece.y;
+         InsertFreeRect(list, &piece);
+      }
+
+   }
+
+   /* Mark new pieces that are inside another rectangle (keeping the
+    * first of identical rectangles). */
+   for(x = count; x < list->count; x++) {
+      for(y = 0; y < list->count; y++) {
+         if(x == y || list->rects[y].width == 0) {
             continue;
          }
-         if(tp == np) {
-            continue;
+         if(IsInside(&list->rects[x], &list->rects[y])) {
+            if(y < x || !IsInside(&list->rects[y], &list->rects[x])) {
+               list->rects[x].width = 0;
+               break;
+            }
          }
-         GetBorderSize(&tp->state, &north, &south, &east, &west);
-         xs[count + 0] = tp->x - west;
-         xs[count + 1] = tp->x + tp->width + east;
-         ys[count + 0] = tp->y - north;
-         ys[count + 1] = tp->y + tp->height + south;
-         count += 2;
       }
    }
 
-   /* Sort the points. */
-   qsort(xs, count, sizeof(int), IntComparator);
-   qsort(ys, count, sizeof(int), IntComparator);
-
-   /* Try all possible positions. */
-   for(i = 0; i < count; i++) {
-      for(j = 0; j < count; j++) {
-         if(TryTileClient(box, np, xs[i], ys[j])) {
-            ReleaseStack(xs);
-            ReleaseStack(ys);
-            return 1;
-         }
+   /* Remove marked rectangles. */
+   y = 0;
+   for(x = 0; x < list->count; x++) {
+      if(list->rects[x].width > 0) {
+         list->rects[y] = list->rects[x];
+         y += 1;
       }
    }
+   list->count = y;
 
-   ReleaseStack(xs);
-   ReleaseStack(ys);
+}
 
-   /* Tiled placement failed. */
-   return 0;
+/** Determine if a rectangle is inside another. */
+char IsInside(const BoundingBox *inner, const BoundingBox *outer)
+{
+   return inner->x >= outer->x
+       && inner->y >= outer->y
+       && inner->x + inner->width <= outer->x + outer->width
+       && inner->y + inner->height <= outer->y + outer->height;
+}
 
+/** Determine if two rectangles overlap. */
+char IsOverlapping(const BoundingBox *a, const BoundingBox *b)
+{
+   return a->x < b->x + b->width && b->x < a->x + a->width
+       && a->y < b->y + b->height && b->y < a->y + a->height;
 }
 
 /** Cascade placement. */
@@ -610,6 +982,139 @@ void CascadeClient(const BoundingBox *box, ClientNode *np)
 
 }
 
+/** Smart placement.
+ * The placement area is divided into a coarse grid that counts the
+ * windows covering each cell. A summed-area table of the grid gives the
+ * overlap of the client at any cell in constant time, so the position
+ * with the least overlap is found in one pass over the grid.
+ */
+void SmartClient(const BoundingBox *box, ClientNode *np)
+{
+
+   const ClientNode *tp;
+   int *cover;
+   int *sums;
+   int layer;
+   int north, south, east, west;
+   int width, height;
+   int cellWidth, cellHeight;
+   int gridWidth, gridHeight;
+   int stride;
+   int x, y;
+   int bestx, besty;
+   int best;
+
+   /* Get the size of the client, including the border. */
+   GetBorderSize(&np->state, &north, &south, &east, &west);
+   np->x = box->x + west;
+   np->y = box->y + north;
+   ConstrainSize(np);
+   width = np->width + east + west;
+   height = np->height + north + south;
+
+   if(JUNLIKELY(box->width <= 0 || box->height <= 0)) {
+      ConstrainPosition(np);
+      return;
+   }
+
+   /* Set up the grid. Both tables have an extra row and column. */
+   cellWidth = Max(1, (box->width + SMART_GRID_SIZE - 1) / SMART_GRID_SIZE);
+   cellHeight = Max(1, (box->height + SMART_GRID_SIZE - 1) / SMART_GRID_SIZE);
+   gridWidth = (box->width + cellWidth - 1) / cellWidth;
+   gridHeight = (box->height + cellHeight - 1) / cellHeight;
+   stride = gridWidth + 1;
+   cover = Allocate(sizeof(int) * stride * (gridHeight + 1) * 2);
+   sums = &cover[stride * (gridHeight + 1)];
+   memset(cover, 0, sizeof(int) * stride * (gridHeight + 1) * 2);
+
+   /* Mark the corners of the cells covered by each visible client. */
+   for(layer = np->state.layer; layer < LAYER_COUNT; layer++) {
+      for(tp = nodes[layer]; tp; tp = tp->next) {
+
+         int x1, x2, y1, y2;
+
+         if(tp->state.desktop != currentDesktop) {
+            if(!(tp->state.status & STAT_STICKY)) {
+               continue;
+            }
+         }
+         if(!(tp->state.status & STAT_MAPPED)) {
+            continue;
+         }
+         if(tp == np) {
+            continue;
+         }
+
+         GetBorderSize(&tp->state, &north, &south, &east, &west);
+         x1 = Max(tp->x - west - box->x, 0);
+         x2 = Min(tp->x + tp->width + east - box->x, box->width);
+         y1 = Max(tp->y - north - box->y, 0);
+         y2 = Min(tp->y + tp->height + south - box->y, box->height);
+         if(x1 >= x2 || y1 >= y2) {
+            continue;
+         }
+         x1 /= cellWidth;
+         x2 = (x2 + cellWidth - 1) / cellWidth;
+         y1 /= cellHeight;
+         y2 = (y2 + cellHeight - 1) / cellHeight;
+         cover[y1 * stride + x1] += 1;
+         cover[y1 * stride + x2] -= 1;
+         cover[y2 * stride + x1] -= 1;
+         cover[y2 * stride + x2] += 1;
+
+      }
+   }
+
+   /* Turn the corners into cell coverage and compute the summed-area
+    * table (offset by one row and column). */
+   for(y = 0; y < gridHeight; y++) {
+      for(x = 0; x < gridWidth; x++) {
+         int *cp = &cover[y * stride + x];
+         if(x > 0) {
+            *cp += cp[-1];
+         }
+         if(y > 0) {
+            *cp += cp[-stride];
+         }
+         if(x > 0 && y > 0) {
+            *cp -= cp[-stride - 1];
+         }
+         sums[(y + 1) * stride + x + 1] = *cp
+            + sums[y * stride + x + 1]
+            + sums[(y + 1) * stride + x]
+            - sums[y * stride + x];
+      }
+   }
+
+   /* Find the left-most, then top-most, position with the least overlap. */
+   width = Min(gridWidth, (width + cellWidth - 1) / cellWidth);
+   height = Min(gridHeight, (height + cellHeight - 1) / cellHeight);
+   bestx = 0;
+   besty = 0;
+   best = -1;
+   for(x = 0; x + width <= gridWidth; x++) {
+      for(y = 0; y + height <= gridHeight; y++) {
+         const int overlap = sums[(y + height) * stride + x + width]
+                           - sums[y * stride + x + width]
+                           - sums[(y + height) * stride + x]
+                           + sums[y * stride + x];
+         if(best < 0 || overlap < best) {
+            best = overlap;
+            bestx = x;
+            besty = y;
+         }
+      }
+   }
+
+   Release(cover);
+
+   GetBorderSize(&np->state, &north, &south, &east, &west);
+   np->x = box->x + bestx * cellWidth + west;
+   np->y = box->y + besty * cellHeight + north;
+   ConstrainPosition(np);
+
+}
+
 /** Place a client on the screen. */
 void PlaceClient(ClientNode *np, char alreadyMapped)
 {
@@ -631,19 +1136,19 @@ void PlaceClient(ClientNode *np, char alreadyMapped)
    } else {
 
       sp = GetMouseScreen();
-      GetScreenBounds(sp, &box);
-      SubtractTrayBounds(GetTrays(), &box, np->state.layer);
-      SubtractStrutBounds(&box, np);
+      GetWorkarea(sp, currentDesktop, np->state.layer, np, &box);
 
       /* If tiled is specified, first attempt to use tiled placement. */
       if(np->state.status & STAT_TILED) {
-         if(TileClient(&box, np)) {
+         if(TileClient(sp, &box, np)) {
             return;
          }
       }
 
       /* Either tiled placement failed or was not specified. */
-      if(np->state.status & STAT_CENTERED) {
+      if(np->state.status & STAT_SMART) {
+         SmartClient(&box, np);
+      } else if(np->state.status & STAT_CENTERED) {
          CenterClient(&box, np);
       } else {
          CascadeClient(&box, np);
@@ -671,9 +1176,7 @@ char ConstrainSize(ClientNode *np)
 
    /* Constrain the width if necessary. */
    sp = GetCurrentScreen(np->x, np->y);
-   GetScreenBounds(sp, &box);
-   SubtractTrayBounds(GetTrays(), &box, np->state.layer);
-   SubtractStrutBounds(&box, np);
+   GetWorkarea(sp, currentDesktop, np->state.layer, np, &box);
    GetBorderSize(&np->state, &north, &south, &east, &west);
    if(np->width + east + west > sp->width) {
       box.x += west;
@@ -733,12 +1236,7 @@ void ConstrainPosition(ClientNode *np)
    int north, south, east, west;
 
    /* Get the bounds for placement. */
-   box.x = 0;
-   box.y = 0;
-   box.width = rootWidth;
-   box.height = rootHeight;
-   SubtractTrayBounds(GetTrays(), &box, np->state.layer);
-   SubtractStrutBounds(&box, np);
+   GetWorkarea(NULL, currentDesktop, np->state.layer, np, &box);
 
    /* Fix the position. */
    GetBorderSize(&np->state, &north, &south, &east, &west);
@@ -774,17 +1272,22 @@ void PlaceMaximizedClient(ClientNode *np, MaxFlags flags)
 
    sp = GetCurrentScreen(np->x + (east + west + np->width) / 2,
                          np->y + (north + south + np->height) / 2);
-   GetScreenBounds(sp, &box);
-   if(!(flags & (MAX_HORIZ | MAX_LEFT | MAX_RIGHT))) {
-      box.x = np->x - west;
-      box.width = np->width + east + west;
-   }
-   if(!(flags & (MAX_VERT | MAX_TOP | MAX_BOTTOM))) {
-      box.y = np->y - north;
-      box.height = np->height + north + south;
+   if(   (flags & (MAX_HORIZ | MAX_LEFT | MAX_RIGHT))
+      && (flags & (MAX_VERT | MAX_TOP | MAX_BOTTOM))) {
+      GetWorkarea(sp, currentDesktop, np->state.layer, np, &box);
+   } else {
+      GetScreenBounds(sp, &box);
+      if(!(flags & (MAX_HORIZ | MAX_LEFT | MAX_RIGHT))) {
+         box.x = np->x - west;
+         box.width = np->width + east + west;
+      }
+      if(!(flags & (MAX_VERT | MAX_TOP | MAX_BOTTOM))) {
+         box.y = np->y - north;
+         box.height = np->height + north + south;
+      }
+      SubtractTrayBounds(GetTrays(), &box, np->state.layer);
+      SubtractStrutBounds(&box, np, currentDesktop);
    }
-   SubtractTrayBounds(GetTrays(), &box, np->state.layer);
-   SubtractStrutBounds(&box, np);
 
    if(box.width > np->maxWidth) {
       box.width = np->maxWidth;
@@ -859,6 +1362,7 @@ void PlaceMaximizedClient(ClientNode *np, MaxFlags flags)
    }
 
    np->state.maxFlags = flags;
+   UpdateBorderSize(np);
 
 }
 
@@ -929,6 +1433,55 @@ void GravitateClient(ClientNode *np, char negate)
 
 }
 
+/** Get the work area for a client.
+ * Unless the client has struts of its own, this comes from the cache.
+ * @param sp The screen (NULL for the whole root window).
+ * @param desktop The desktop.
+ * @param layer The layer of the client.
+ * @param np The client whose struts to ignore (or NULL).
+ * @param box Location to store the work area.
+ */
+void GetWorkarea(const ScreenType *sp, unsigned int desktop,
+                 unsigned int layer, const ClientNode *np, BoundingBox *box)
+{
+
+   int index;
+
+   Assert(layer < LAYER_COUNT);
+   Assert(desktop < settings.desktopCount);
+
+   if(np && np->hasStruts) {
+      ComputeWorkarea(sp, desktop, layer, np, box);
+      return;
+   }
+
+   index = sp ? sp->index : GetScreenCount();
+   index = (index * settings.desktopCount + desktop) * LAYER_COUNT + layer;
+   if(!workareaValid[index]) {
+      ComputeWorkarea(sp, desktop, layer, NULL, &workareas[index]);
+      workareaValid[index] = 1;
+   }
+   *box = workareas[index];
+
+}
+
+/** Compute the work area for a client. */
+void ComputeWorkarea(const ScreenType *sp, unsigned int desktop,
+                     unsigned int layer, const ClientNode *np,
+                     BoundingBox *box)
+{
+   if(sp) {
+      GetScreenBounds(sp, box);
+   } else {
+      box->x = 0;
+      box->y = 0;
+      box->width = rootWidth;
+      box->height = rootHeight;
+   }
+   SubtractTrayBounds(GetTrays(), box, layer);
+   SubtractStrutBounds(box, np, desktop);
+}
+
 /** Set _NET_WORKAREA. */
 void SetWorkarea(void)
 {
@@ -937,18 +1490,16 @@ void SetWorkarea(void)
    unsigned int count;
    int x;
 
+   if(JUNLIKELY(!workareas)) {
+      return;
+   }
+   memset(workareaValid, 0, workareaCount);
+
    count = 4 * settings.desktopCount * sizeof(unsigned long);
    array = (unsigned long*)AllocateStack(count);
 
-   box.x = 0;
-   box.y = 0;
-   box.width = rootWidth;
-   box.height = rootHeight;
-
-   SubtractTrayBounds(GetTrays(), &box, LAYER_NORMAL);
-   SubtractStrutBounds(&box, NULL);
-
    for(x = 0; x < settings.desktopCount; x++) {
+      GetWorkarea(NULL, x, LAYER_NORMAL, NULL, &box);
       array[x * 4 + 0] = box.x;
       array[x * 4 + 1] = box.y;
       array[x * 4 + 2] = box.width;
@@ -40,12 +40,29 @@ void RemoveClientStrut(ClientNode *np);
  */
 void ReadClientStrut(ClientNode *np);
 
+/** Update the work area after the desktop of a client changes.
+ * @param np The client.
+ */
+void UpdateClientStrut(const ClientNode *np);
+
 /** Place a client on the screen.
  * @param np The client to place.
  * @param alreadyMapped 1 if already mapped, 0 if unmapped.
  */
 void PlaceClient(ClientNode *np, char alreadyMapped);
 
+/** Update the free space used for tiled placement.
+ * This should be called when a client is mapped, unmapped, moved, or
+ * resized, or when its layer or desktop changes.
+ * @param np The client.
+ */
+void UpdateFreeSpace(const ClientNode *np);
+
+/** Return the free space used by a client that is being removed.
+ * @param np The client.
+ */
+void RemoveFreeSpaceClient(const ClientNode *np);
+
 /** Place a maximized client on the screen.
  * @param np The client to place.
  * @param flags The type of maximization to perform.
@@ -83,6 +100,11 @@ void ConstrainPosition(ClientNode *np);
  */
 void GetScreenBounds(const struct ScreenType *sp, BoundingBox *box);
 
+/** Update _NET_WORKAREA and the cached work areas.
+ * This should be called when the geometry of a tray changes.
+ */
+void SetWorkarea(void);
+
 /** Subtract bounds for the configured trays.
  * @param tp The first tray to consider.
  * @param box The bounding box.
@@ -18,13 +18,39 @@
 #include "key.h"
 #include "event.h"
 #include "settings.h"
+#include "timing.h"
+#include "hint.h"
+#include "main.h"
+#include "place.h"
+
+/** Time in milliseconds to wait for a client to acknowledge a resize. */
+#define RESIZE_SYNC_TIMEOUT   250
 
 static char shouldStopResize;
 
+#ifdef USE_XSYNC
+static ClientNode *syncClient;
+static XSyncAlarm syncAlarm = None;
+static XSyncValue syncValue;
+static TimeType syncTime;
+static char syncPending;
+static char resizePending;
+#endif
+
 static void StopResize(ClientNode *np);
 static void ResizeController(int wasDestroyed);
 static void FixWidth(ClientNode *np);
 static void FixHeight(ClientNode *np);
+static void UpdateResize(ClientNode *np);
+
+static void StartResizeSync(ClientNode *np);
+static void StopResizeSync(void);
+static char HandleResizeSync(ClientNode *np, const XEvent *event);
+#ifdef USE_XSYNC
+static void SendResizeSync(ClientNode *np);
+static void SignalResize(const TimeType *now, int x, int y, Window w,
+                         void *data);
+#endif
 
 /** Callback to stop a resize. */
 void ResizeController(int wasDestroyed)
@@ -35,6 +61,7 @@ void ResizeController(int wasDestroyed)
    JXUngrabPointer(display, CurrentTime);
    JXUngrabKeyboard(display, CurrentTime);
    DestroyResizeWindow();
+   StopResizeSync();
    shouldStopResize = 1;
 }
 
@@ -83,6 +110,7 @@ void ResizeClient(ClientNode *np, BorderActionType action,
 
    CreateResizeWindow(np);
    UpdateResizeWindow(np, gwidth, gheight);
+   StartResizeSync(np);
 
    if(!(GetMouseMask() & (Button1Mask | Button3Mask))) {
       StopResize(np);
@@ -97,6 +125,9 @@ void ResizeClient(ClientNode *np, BorderActionType action,
          np->controller = NULL;
          return;
       }
+      if(HandleResizeSync(np, &event)) {
+         continue;
+      }
 
       switch(event.type) {
       case ButtonRelease:
@@ -189,7 +220,6 @@ void ResizeClient(ClientNode *np, BorderActionType action,
             UpdateResizeWindow(np, gwidth, gheight);
 
             if(settings.resizeMode == RESIZE_OUTLINE) {
-               ClearOutline();
                if(np->state.status & STAT_SHADED) {
                   DrawOutline(np->x - west, np->y - north,
                      np->width + west + east, north + south);
@@ -198,13 +228,11 @@ void ResizeClient(ClientNode *np, BorderActionType action,
                      np->width + west + east,
                      np->height + north + south);
                }
+               UpdatePager();
             } else {
-               ResetBorder(np);
-               SendConfigureEvent(np);
+               UpdateResize(np);
             }
 
-            UpdatePager();
-
          }
 
          break;
@@ -252,6 +280,7 @@ void ResizeClientKeyboard(ClientNode *np)
 
    CreateResizeWindow(np);
    UpdateResizeWindow(np, gwidth, gheight);
+   StartResizeSync(np);
 
    if(np->state.status & STAT_SHADED) {
       MoveMouse(rootWindow, np->x + np->width, np->y);
@@ -268,6 +297,9 @@ void ResizeClientKeyboard(ClientNode *np)
          np->controller = NULL;
          return;
       }
+      if(HandleResizeSync(np, &event)) {
+         continue;
+      }
 
       deltax = 0;
       deltay = 0;
@@ -352,7 +384,6 @@ void ResizeClientKeyboard(ClientNode *np)
          UpdateResizeWindow(np, gwidth, gheight);
 
          if(settings.resizeMode == RESIZE_OUTLINE) {
-            ClearOutline();
             if(np->state.status & STAT_SHADED) {
                DrawOutline(np->x - west, np->y - north,
                   np->width + west + east,
@@ -362,13 +393,11 @@ void ResizeClientKeyboard(ClientNode *np)
                   np->width + west + east,
                   np->height + north + south);
             }
+            UpdatePager();
          } else {
-            ResetBorder(np);
-            SendConfigureEvent(np);
+            UpdateResize(np);
          }
 
-         UpdatePager();
-
       }
 
    }
@@ -400,12 +429,180 @@ void StopResize(ClientNode *np)
    JXUngrabKeyboard(display, CurrentTime);
 
    DestroyResizeWindow();
+   StopResizeSync();
 
    ResetBorder(np);
+   UpdateFreeSpace(np);
    SendConfigureEvent(np);
+   UpdatePager();
 
 }
 
+/** Apply the current size of a client during an opaque resize.
+ * If the client supports _NET_WM_SYNC_REQUEST, the size is held back
+ * until the client has redrawn after the previous one so that the
+ * resize proceeds at the rate the client can keep up with.
+ */
+void UpdateResize(ClientNode *np)
+{
+
+#ifdef USE_XSYNC
+   if(syncAlarm != None) {
+      if(syncPending) {
+         TimeType now;
+         GetCurrentTime(&now);
+         if(GetTimeDifference(&now, &syncTime) < RESIZE_SYNC_TIMEOUT) {
+            resizePending = 1;
+            return;
+         }
+      }
+      SendResizeSync(np);
+   }
+#endif
+
+   ResetBorder(np);
+   UpdateFreeSpace(np);
+   SendConfigureEvent(np);
+   UpdatePager();
+
+}
+
+/** Set up the _NET_WM_SYNC_REQUEST counter alarm for a resize. */
+void StartResizeSync(ClientNode *np)
+{
+
+#ifdef USE_XSYNC
+
+   XSyncAlarmAttributes attr;
+   XSyncValue one;
+   unsigned long counter;
+   int overflow;
+
+   syncPending = 0;
+   resizePending = 0;
+   if(!haveSync || settings.resizeMode == RESIZE_OUTLINE) {
+      return;
+   }
+   if(!(np->state.status & STAT_SYNC)) {
+      return;
+   }
+   if(!GetCardinalAtom(np->window, ATOM_NET_WM_SYNC_REQUEST_COUNTER,
+                       &counter) || counter == None) {
+      return;
+   }
+   if(!JXSyncQueryCounter(display, counter, &syncValue)) {
+      return;
+   }
+
+   /* The alarm fires when the client sets the counter to the value
+    * of the last request. A non-zero delta keeps the alarm active
+    * after it fires so that it fires again for the next request. */
+   XSyncIntToValue(&one, 1);
+   XSyncValueAdd(&syncValue, syncValue, one, &overflow);
+   attr.trigger.counter = counter;
+   attr.trigger.value_type = XSyncAbsolute;
+   attr.trigger.wait_value = syncValue;
+   attr.trigger.test_type = XSyncPositiveComparison;
+   attr.delta = one;
+   attr.events = True;
+   syncAlarm = JXSyncCreateAlarm(display,
+                                 XSyncCACounter | XSyncCAValueType
+                                 | XSyncCAValue | XSyncCATestType
+                                 | XSyncCADelta | XSyncCAEvents,
+                                 &attr);
+   if(syncAlarm != None) {
+      syncClient = np;
+      RegisterCallback(RESIZE_SYNC_TIMEOUT / 5, SignalResize, NULL);
+   }
+
+#endif
+
+}
+
+/** Release the _NET_WM_SYNC_REQUEST counter alarm. */
+void StopResizeSync(void)
+{
+#ifdef USE_XSYNC
+   if(syncAlarm != None) {
+      UnregisterCallback(SignalResize, NULL);
+      JXSyncDestroyAlarm(display, syncAlarm);
+      syncAlarm = None;
+   }
+   syncPending = 0;
+   resizePending = 0;
+#endif
+}
+
+/** Handle an alarm event for the _NET_WM_SYNC_REQUEST counter.
+ * The held back size is applied as soon as the counter reaches the
+ * value of the last request; SignalResize only handles the timeout.
+ * @return 1 if the event was handled, 0 otherwise.
+ */
+char HandleResizeSync(ClientNode *np, const XEvent *event)
+{
+#ifdef USE_XSYNC
+   if(syncAlarm != None && event->type == syncEvent + XSyncAlarmNotify) {
+      const XSyncAlarmNotifyEvent *se = (const XSyncAlarmNotifyEvent*)event;
+      if(se->alarm == syncAlarm
+         && !XSyncValueLessThan(se->counter_value, syncValue)) {
+         syncPending = 0;
+         if(resizePending) {
+            resizePending = 0;
+            UpdateResize(np);
+         }
+      }
+      return 1;
+   }
+#endif
+   return 0;
+}
+
+#ifdef USE_XSYNC
+
+/** Ask the client to update its counter after the next configure. */
+void SendResizeSync(ClientNode *np)
+{
+
+   XSyncAlarmAttributes attr;
+   XSyncValue one;
+   XEvent event;
+   int overflow;
+
+   XSyncIntToValue(&one, 1);
+   XSyncValueAdd(&syncValue, syncValue, one, &overflow);
+
+   memset(&event, 0, sizeof(event));
+   event.xclient.type = ClientMessage;
+   event.xclient.window = np->window;
+   event.xclient.message_type = atoms[ATOM_WM_PROTOCOLS];
+   event.xclient.format = 32;
+   event.xclient.data.l[0] = atoms[ATOM_NET_WM_SYNC_REQUEST];
+   event.xclient.data.l[1] = eventTime;
+   event.xclient.data.l[2] = XSyncValueLow32(syncValue);
+   event.xclient.data.l[3] = XSyncValueHigh32(syncValue);
+   JXSendEvent(display, np->window, False, NoEventMask, &event);
+
+   attr.trigger.wait_value = syncValue;
+   JXSyncChangeAlarm(display, syncAlarm, XSyncCAValue, &attr);
+
+   GetCurrentTime(&syncTime);
+   syncPending = 1;
+   resizePending = 0;
+
+}
+
+/** Apply a held back size if the client did not respond in time. */
+void SignalResize(const TimeType *now, int x, int y, Window w, void *data)
+{
+   if(resizePending
+      && GetTimeDifference(now, &syncTime) >= RESIZE_SYNC_TIMEOUT) {
+      syncPending = 0;
+      UpdateResize(syncClient);
+   }
+}
+
+#endif /* USE_XSYNC */
+
 /** Fix the width to match the aspect ratio. */
 void FixWidth(ClientNode *np)
 {
@@ -62,6 +62,17 @@ void StartupRootMenu(void)
 
 }
 
+/** Shutdown root menus. */
+void ShutdownRootMenu(void)
+{
+   unsigned int x;
+   for(x = 0; x < ROOT_MENU_COUNT; x++) {
+      if(rootMenu[x]) {
+         ReleaseMenuPixmaps(rootMenu[x]);
+      }
+   }
+}
+
 /** Destroy root menu data. */
 void DestroyRootMenu(void)
 {
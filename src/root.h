@@ -15,7 +15,7 @@ struct Menu;
 /*@{*/
 void InitializeRootMenu(void);
 void StartupRootMenu(void);
-#define ShutdownRootMenu() (void)(0)
+void ShutdownRootMenu(void);
 void DestroyRootMenu(void);
 /*@}*/
 
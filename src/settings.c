@@ -29,6 +29,7 @@ void InitializeSettings(void)
    settings.resizeMode = RESIZE_OPAQUE;
    settings.popupDelay = 600;
    settings.desktopDelay = 1000;
+   settings.moveRate = 60;
    settings.trayOpacity = UINT_MAX;
    settings.popupEnabled = 1;
    settings.activeClientOpacity = UINT_MAX;
@@ -52,6 +53,8 @@ void StartupSettings(void)
    FixRange(&settings.borderWidth, 1, 128, 4);
    FixRange(&settings.titleHeight, 2, 256, 20);
 
+   FixRange(&settings.moveRate, 0, 1000, 60);
+
    FixRange(&settings.doubleClickDelta, 0, 64, 2);
    FixRange(&settings.doubleClickSpeed, 1, 2000, 400);
 
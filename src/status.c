@@ -5,6 +5,10 @@
  *
  * @brief Functions for display window move/resize status.
  *
+ * The status window is created once and mapped while a move or resize
+ * is in progress. Text is drawn by copying characters from a strip of
+ * pre-rendered glyphs so that updates do not need to measure strings.
+ *
  */
 
 #include "jwm.h"
@@ -14,19 +18,103 @@
 #include "main.h"
 #include "client.h"
 #include "settings.h"
+#include "misc.h"
+
+/** Characters available in the glyph strip. */
+static const char STATUS_GLYPHS[] = " 0123456789-(),x";
+#define STATUS_GLYPH_COUNT (sizeof(STATUS_GLYPHS) - 1)
 
 static Window statusWindow;
+static Pixmap glyphPixmap;
+static unsigned int glyphOffsets[STATUS_GLYPH_COUNT];
+static unsigned int glyphWidths[STATUS_GLYPH_COUNT];
+static unsigned int glyphHeight;
+static char statusMapped;
 static unsigned int statusWindowHeight;
 static unsigned int statusWindowWidth;
 static int statusWindowX, statusWindowY;
 
+static void CreateGlyphStrip(void);
+static unsigned int GetGlyphIndex(char ch);
+static unsigned int GetGlyphStringWidth(const char *str);
 static void CreateMoveResizeWindow(const ClientNode *np,
                                    StatusWindowType type);
-static void DrawMoveResizeWindow(const ClientNode *np, StatusWindowType type);
+static void DrawMoveResizeWindow(const ClientNode *np, StatusWindowType type,
+                                 const char *str);
 static void DestroyMoveResizeWindow(void);
 static void GetMoveResizeCoordinates(const ClientNode *np,
                                      StatusWindowType type, int *x, int *y);
 
+/** Initialize status window data. */
+void InitializeStatus(void)
+{
+   statusWindow = None;
+   glyphPixmap = None;
+   statusMapped = 0;
+}
+
+/** Shutdown the status window. */
+void ShutdownStatus(void)
+{
+   if(statusWindow != None) {
+      JXDestroyWindow(display, statusWindow);
+      statusWindow = None;
+   }
+   if(glyphPixmap != None) {
+      JXFreePixmap(display, glyphPixmap);
+      glyphPixmap = None;
+   }
+   statusMapped = 0;
+}
+
+/** Render the glyph strip. */
+void CreateGlyphStrip(void)
+{
+
+   char str[2];
+   unsigned int width;
+   unsigned int i;
+
+   str[1] = 0;
+   width = 0;
+   for(i = 0; i < STATUS_GLYPH_COUNT; i++) {
+      str[0] = STATUS_GLYPHS[i];
+      glyphOffsets[i] = width;
+      glyphWidths[i] = GetStringWidth(FONT_MENU, str);
+      width += glyphWidths[i];
+   }
+   glyphHeight = GetStringHeight(FONT_MENU);
+
+   glyphPixmap = JXCreatePixmap(display, rootWindow, Max(width, 1),
+                                glyphHeight, rootVisual.depth);
+   JXSetForeground(display, rootGC, colors[COLOR_MENU_BG]);
+   JXFillRectangle(display, glyphPixmap, rootGC, 0, 0, width, glyphHeight);
+   for(i = 0; i < STATUS_GLYPH_COUNT; i++) {
+      str[0] = STATUS_GLYPHS[i];
+      RenderString(&rootVisual, glyphPixmap, FONT_MENU, COLOR_MENU_FG,
+                   glyphOffsets[i], 0, glyphWidths[i], str);
+   }
+
+}
+
+/** Get the index of a character in the glyph strip. */
+unsigned int GetGlyphIndex(char ch)
+{
+   const char *p = strchr(STATUS_GLYPHS, ch);
+   return (p && ch) ? (unsigned int)(p - STATUS_GLYPHS) : 0;
+}
+
+/** Get the width of a string drawn from the glyph strip. */
+unsigned int GetGlyphStringWidth(const char *str)
+{
+   unsigned int width = 0;
+   while(*str) {
+      width += glyphWidths[GetGlyphIndex(*str)];
+      str += 1;
+   }
+   return width;
+}
+
 /** Get the location to place the status window. */
 void GetMoveResizeCoordinates(const ClientNode *np, StatusWindowType type,
                               int *x, int *y)
@@ -54,7 +142,7 @@ void GetMoveResizeCoordinates(const ClientNode *np, StatusWindowType type,
 
 }
 
-/** Create the status window. */
+/** Show the status window. */
 void CreateMoveResizeWindow(const ClientNode *np, StatusWindowType type)
 {
 
@@ -65,60 +153,83 @@ void CreateMoveResizeWindow(const ClientNode *np, StatusWindowType type)
       return;
    }
 
-   statusWindowHeight = GetStringHeight(FONT_MENU) + 8;
-   statusWindowWidth = GetStringWidth(FONT_MENU, " 00000 x 00000 ");
+   if(statusWindow == None) {
 
-   GetMoveResizeCoordinates(np, type, &statusWindowX, &statusWindowY);
+      CreateGlyphStrip();
+      statusWindowHeight = glyphHeight + 8;
+      statusWindowWidth = GetGlyphStringWidth(" 00000 x 00000 ");
 
-   attrMask = 0;
+      attrMask = 0;
 
-   attrMask |= CWBackPixel;
-   attrs.background_pixel = colors[COLOR_MENU_BG];
+      attrMask |= CWBackPixel;
+      attrs.background_pixel = colors[COLOR_MENU_BG];
 
-   attrMask |= CWSaveUnder;
-   attrs.save_under = True;
+      attrMask |= CWSaveUnder;
+      attrs.save_under = True;
 
-   attrMask |= CWOverrideRedirect;
-   attrs.override_redirect = True;
+      attrMask |= CWOverrideRedirect;
+      attrs.override_redirect = True;
 
-   attrMask |= CWBorderPixel;
-   attrs.border_pixel = colors[COLOR_MENU_OUTLINE];
+      attrMask |= CWBorderPixel;
+      attrs.border_pixel = colors[COLOR_MENU_OUTLINE];
 
-   statusWindow = JXCreateWindow(display, rootWindow,
-      statusWindowX, statusWindowY,
-      statusWindowWidth, statusWindowHeight, 1,
-      CopyFromParent, InputOutput, CopyFromParent,
-      attrMask, &attrs);
+      statusWindow = JXCreateWindow(display, rootWindow, 0, 0,
+         statusWindowWidth, statusWindowHeight, 1,
+         CopyFromParent, InputOutput, CopyFromParent,
+         attrMask, &attrs);
+
+   }
 
+   GetMoveResizeCoordinates(np, type, &statusWindowX, &statusWindowY);
+   JXMoveWindow(display, statusWindow, statusWindowX, statusWindowY);
    JXMapRaised(display, statusWindow);
+   statusMapped = 1;
 
 }
 
 /** Draw the status window. */
-void DrawMoveResizeWindow(const ClientNode *np, StatusWindowType type)
+void DrawMoveResizeWindow(const ClientNode *np, StatusWindowType type,
+                          const char *str)
 {
 
+   unsigned int width;
+   unsigned int index;
    int x, y;
 
+   if(!statusMapped) {
+      return;
+   }
+
    GetMoveResizeCoordinates(np, type, &x, &y);
-   if(x != statusWindowX || y != statusWindowX) {
+   if(x != statusWindowX || y != statusWindowY) {
       statusWindowX = x;
       statusWindowY = y;
-      JXMoveResizeWindow(display, statusWindow, x, y,
-                         statusWindowWidth, statusWindowHeight);
+      JXMoveWindow(display, statusWindow, x, y);
    }
 
    /* Clear the background. */
    JXClearWindow(display, statusWindow);
 
+   /* Copy the text from the glyph strip. */
+   width = GetGlyphStringWidth(str);
+   x = width < statusWindowWidth ? (statusWindowWidth - width) / 2 : 0;
+   while(*str) {
+      index = GetGlyphIndex(*str);
+      JXCopyArea(display, glyphPixmap, statusWindow, rootGC,
+                 glyphOffsets[index], 0, glyphWidths[index], glyphHeight,
+                 x, 4);
+      x += glyphWidths[index];
+      str += 1;
+   }
+
 }
 
-/** Destroy the status window. */
+/** Hide the status window. */
 void DestroyMoveResizeWindow(void)
 {
-   if(statusWindow != None) {
-      JXDestroyWindow(display, statusWindow);
-      statusWindow = None;
+   if(statusMapped) {
+      JXUnmapWindow(display, statusWindow);
+      statusMapped = 0;
    }
 }
 
@@ -132,18 +243,8 @@ void CreateMoveWindow(ClientNode *np)
 void UpdateMoveWindow(ClientNode *np)
 {
    char str[80];
-   unsigned int width;
-
-   if(settings.moveStatusType == SW_OFF) {
-      return;
-   }
-
-   DrawMoveResizeWindow(np, settings.moveStatusType);
-
    snprintf(str, sizeof(str), "(%d, %d)", np->x, np->y);
-   width = GetStringWidth(FONT_MENU, str);
-   RenderString(&rootVisual, statusWindow, FONT_MENU, COLOR_MENU_FG,
-                (statusWindowWidth - width) / 2, 4, rootWidth, str);
+   DrawMoveResizeWindow(np, settings.moveStatusType, str);
 }
 
 /** Destroy the move status window. */
@@ -161,21 +262,9 @@ void CreateResizeWindow(ClientNode *np)
 /** Update the resize status window. */
 void UpdateResizeWindow(ClientNode *np, int gwidth, int gheight)
 {
-
    char str[80];
-   unsigned int fontWidth;
-
-   if(settings.resizeStatusType == SW_OFF) {
-      return;
-   }
-
-   DrawMoveResizeWindow(np, settings.resizeStatusType);
-
    snprintf(str, sizeof(str), "%d x %d", gwidth, gheight);
-   fontWidth = GetStringWidth(FONT_MENU, str);
-   RenderString(&rootVisual, statusWindow, FONT_MENU, COLOR_MENU_FG,
-                (statusWindowWidth - fontWidth) / 2, 4, rootWidth, str);
-
+   DrawMoveResizeWindow(np, settings.resizeStatusType, str);
 }
 
 /** Destroy the resize status window. */
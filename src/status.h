@@ -12,6 +12,13 @@
 
 struct ClientNode;
 
+/*@{*/
+void InitializeStatus(void);
+#define StartupStatus()    (void)(0)
+void ShutdownStatus(void);
+#define DestroyStatus()    (void)(0)
+/*@}*/
+
 /** Create a move status window.
  * @param np The client to be moved.
  */
@@ -24,6 +24,24 @@
 #include "screen.h"
 #include "settings.h"
 #include "event.h"
+#include "misc.h"
+#include "menu.h"
+
+struct Node;
+
+/** A rendered task bar button. */
+typedef struct TaskButtonType {
+   struct Node *node;         /**< The item (NULL if removed). */
+   Pixmap pixmap;             /**< The rendered button (or None). */
+   int x, y;                  /**< Location on the task bar. */
+   int width, height;         /**< Size including spacing. */
+   ButtonType type;           /**< Type of button rendered. */
+   char minimized;            /**< Set if rendered as minimized. */
+   unsigned int count;        /**< Number of items rendered. */
+   const struct IconNode *icon;  /**< Icon rendered. */
+   unsigned int iconSerial;   /**< Serial of the icon rendered. */
+   char *name;                /**< Name rendered (or NULL). */
+} TaskButtonType;
 
 typedef struct TaskBarType {
 
@@ -33,19 +51,42 @@ typedef struct TaskBarType {
    LayoutType layout;
 
    Pixmap buffer;
+   Pixmap background;         /**< Background of the task bar. */
+
+   TaskButtonType *buttons;   /**< Visible buttons in order. */
+   unsigned int buttonCount;  /**< Number of visible buttons. */
+   unsigned int buttonMax;    /**< Size of the buttons array. */
+   int extent;                /**< Space used by the buttons. */
+   int itemWidth;             /**< Width of buttons (horizontal only). */
+   int remainder;             /**< Buttons with an extra pixel. */
+   char valid;                /**< Set if the buffer matches buttons. */
 
    TimeType mouseTime;
    int mousex, mousey;
 
    unsigned int maxItemWidth;
+   char grouped;              /**< Set to show one button per class. */
 
    struct TaskBarType *next;
 
 } TaskBarType;
 
+/** A group of task bar items with the same window class. */
+typedef struct GroupType {
+   char *name;                /**< The window class (or NULL). */
+   unsigned int count;        /**< Number of items in the group. */
+   unsigned int visible;      /**< Number of visible items. */
+   struct Node *node;         /**< The item shown for the group. */
+   struct GroupType *next;
+   struct GroupType *prev;
+} GroupType;
+
 typedef struct Node {
    ClientNode *client;
+   GroupType *group;
    int y;
+   int button;                /**< Index in the old button list or -1. */
+   char visible;              /**< Set if the item is shown. */
    struct Node *next;
    struct Node *prev;
 } Node;
@@ -53,14 +94,36 @@ typedef struct Node {
 static TaskBarType *bars;
 static Node *taskBarNodes;
 static Node *taskBarNodesTail;
+static TaskButtonType *scratchButtons;
+static unsigned int scratchButtonMax;
+static Node **visibleNodes;
+static unsigned int visibleCount;
+static unsigned int visibleMax;
+static GroupType *groups;
+static GroupType **visibleGroups;
+static unsigned int visibleGroupCount;
+static unsigned int visibleGroupMax;
+static char visibleDirty;
+static XContext nodeContext;
+static Window *groupWindows;
 
 static Node *GetNode(TaskBarType *bar, int x);
-static unsigned int GetItemCount(void);
+static unsigned int GetItemCount(const TaskBarType *bp);
+static void UpdateVisibleNodes(void);
+static void SetNodeVisible(Node *tp, char visible);
+static GroupType *GetGroup(const char *name);
+static void ReleaseGroup(GroupType *gp);
 static unsigned int GetItemWidth(const TaskBarType *bp,
                                  unsigned int itemCount);
-static void Render(const TaskBarType *bp);
+static void Render(TaskBarType *bp);
+static void RenderButton(const TaskBarType *bp, TaskButtonType *button);
+static void ReleaseButton(TaskButtonType *button);
+static char IsSameName(const char *a, const char *b);
 static void ShowTaskWindowMenu(TaskBarType *bar, Node *np);
-
+static void ShowTaskGroupMenu(TaskBarType *bar, Node *np);
+static void GetTaskMenuPosition(const TaskBarType *bar, const Node *np,
+                                int mwidth, int mheight, int *x, int *y);
+static void RunTaskGroupCommand(const MenuAction *action);
 static void SetSize(TrayComponentType *cp, int width, int height);
 static void Create(TrayComponentType *cp);
 static void Resize(TrayComponentType *cp);
@@ -77,14 +140,32 @@ void InitializeTaskBar(void)
    bars = NULL;
    taskBarNodes = NULL;
    taskBarNodesTail = NULL;
+   scratchButtons = NULL;
+   scratchButtonMax = 0;
+   visibleNodes = NULL;
+   visibleCount = 0;
+   visibleMax = 0;
+   groups = NULL;
+   visibleGroups = NULL;
+   visibleGroupCount = 0;
+   visibleGroupMax = 0;
+   visibleDirty = 0;
+   nodeContext = XUniqueContext();
+   groupWindows = NULL;
 }
 
 /** Shutdown the task bar. */
 void ShutdownTaskBar(void)
 {
    TaskBarType *bp;
+   unsigned int i;
    for(bp = bars; bp; bp = bp->next) {
       JXFreePixmap(display, bp->buffer);
+      JXFreePixmap(display, bp->background);
+      for(i = 0; i < bp->buttonCount; i++) {
+         ReleaseButton(&bp->buttons[i]);
+      }
+      bp->buttonCount = 0;
    }
 }
 
@@ -92,9 +173,29 @@ void ShutdownTaskBar(void)
 void DestroyTaskBar(void)
 {
    TaskBarType *bp;
+   if(scratchButtons) {
+      Release(scratchButtons);
+      scratchButtons = NULL;
+      scratchButtonMax = 0;
+   }
+   if(visibleNodes) {
+      Release(visibleNodes);
+      visibleNodes = NULL;
+      visibleCount = 0;
+      visibleMax = 0;
+   }
+   if(visibleGroups) {
+      Release(visibleGroups);
+      visibleGroups = NULL;
+      visibleGroupCount = 0;
+      visibleGroupMax = 0;
+   }
    while(bars) {
       bp = bars->next;
       UnregisterCallback(SignalTaskbar, bars);
+      if(bars->buttons) {
+         Release(bars->buttons);
+      }
       Release(bars);
       bars = bp;
    }
@@ -117,6 +218,16 @@ TrayComponentType *CreateTaskBar()
    tp->mouseTime.seconds = 0;
    tp->mouseTime.ms = 0;
    tp->maxItemWidth = 0;
+   tp->grouped = 0;
+   tp->buffer = None;
+   tp->background = None;
+   tp->buttons = NULL;
+   tp->buttonCount = 0;
+   tp->buttonMax = 0;
+   tp->extent = 0;
+   tp->itemWidth = 0;
+   tp->remainder = 0;
+   tp->valid = 0;
 
    cp = CreateTrayComponent();
    cp->object = tp;
@@ -185,6 +296,12 @@ void Create(TrayComponentType *cp)
 
    ClearTrayDrawable(cp);
 
+   tp->background = JXCreatePixmap(display, rootWindow, cp->width,
+                                   cp->height, rootVisual.depth);
+   JXCopyArea(display, cp->pixmap, tp->background, rootGC, 0, 0,
+              cp->width, cp->height, 0, 0);
+   tp->valid = 0;
+
 }
 
 /** Resize a task bar tray component. */
@@ -202,6 +319,9 @@ void Resize(TrayComponentType *cp)
    if(tp->buffer != None) {
       JXFreePixmap(display, tp->buffer);
    }
+   if(tp->background != None) {
+      JXFreePixmap(display, tp->background);
+   }
 
    if(tp->layout == LAYOUT_HORIZONTAL) {
       tp->itemHeight = cp->height;
@@ -217,6 +337,14 @@ void Resize(TrayComponentType *cp)
    tp->buffer = cp->pixmap;
 
    ClearTrayDrawable(cp);
+
+   tp->background = JXCreatePixmap(display, rootWindow, cp->width,
+                                   cp->height, rootVisual.depth);
+   JXCopyArea(display, cp->pixmap, tp->background, rootGC, 0, 0,
+              cp->width, cp->height, 0, 0);
+   tp->valid = 0;
+
+   Render(tp);
 }
 
 /** Process a task list button event. */
@@ -237,7 +365,9 @@ void ProcessTaskButtonEvent(TrayComponentType *cp, int x, int y, int mask)
    if(np) {
       switch(mask) {
       case Button1:
-         if((np->client->state.status & STAT_ACTIVE) &&
+         if(bar->grouped && np->group->visible > 1) {
+            ShowTaskGroupMenu(bar, np);
+         } else if((np->client->state.status & STAT_ACTIVE) &&
             !(np->client->state.status & STAT_MINIMIZED)) {
             MinimizeClient(np->client, 1);
          } else {
@@ -276,32 +406,100 @@ void ShowTaskWindowMenu(TaskBarType *bar, Node *np)
 
    int x, y;
    int mwidth, mheight;
-   const ScreenType *sp;
-   Window w;
 
    GetWindowMenuSize(np->client, &mwidth, &mheight);
+   GetTaskMenuPosition(bar, np, mwidth, mheight, &x, &y);
+   ShowWindowMenu(np->client, x, y);
+
+}
+
+/** Show a menu to select a client from a task list group. */
+void ShowTaskGroupMenu(TaskBarType *bar, Node *np)
+{
+
+   Menu *menu;
+   MenuItem *item;
+   Node *tp;
+   unsigned int index;
+   int x, y;
+
+   menu = Allocate(sizeof(Menu));
+   menu->itemHeight = 0;
+   menu->items = NULL;
+   menu->label = NULL;
+
+   /* Clients are looked up by window when selected in case they go away
+    * while the menu is shown. */
+   groupWindows = Allocate(np->group->visible * sizeof(Window));
+
+   /* Note that items are added in reverse order of display. */
+   index = np->group->visible;
+   for(tp = taskBarNodesTail; tp; tp = tp->prev) {
+      if(tp->group == np->group && tp->visible) {
+         index -= 1;
+         groupWindows[index] = tp->client->window;
+         item = Allocate(sizeof(MenuItem));
+         item->type = MENU_ITEM_NORMAL;
+         item->name = CopyString(tp->client->name ? tp->client->name : "");
+         item->action.type = MA_RESTORE;
+         item->action.data.i = index;
+         item->iconName = NULL;
+         item->submenu = NULL;
+         item->next = menu->items;
+         menu->items = item;
+         if(index == 0) {
+            break;
+         }
+      }
+   }
+
+   InitializeMenu(menu);
+   GetTaskMenuPosition(bar, np, menu->width, menu->height, &x, &y);
+   ShowMenu(menu, RunTaskGroupCommand, x, y);
+   DestroyMenu(menu);
+
+   Release(groupWindows);
+   groupWindows = NULL;
+
+}
+
+/** Task list group menu action callback. */
+void RunTaskGroupCommand(const MenuAction *action)
+{
+   ClientNode *np = FindClientByWindow(groupWindows[action->data.i]);
+   if(np) {
+      RestoreClient(np, 1);
+      FocusClient(np);
+   }
+}
+
+/** Get the location of a menu for a task list item. */
+void GetTaskMenuPosition(const TaskBarType *bar, const Node *np,
+                         int mwidth, int mheight, int *x, int *y)
+{
+
+   const ScreenType *sp;
+   Window w;
 
    sp = GetCurrentScreen(bar->cp->screenx, bar->cp->screeny);
 
    if(bar->layout == LAYOUT_HORIZONTAL) {
-      GetMousePosition(&x, &y, &w);
+      GetMousePosition(x, y, &w);
       if(bar->cp->screeny + bar->cp->height / 2 < sp->y + sp->height / 2) {
-         y = bar->cp->screeny + bar->cp->height;
+         *y = bar->cp->screeny + bar->cp->height;
       } else {
-         y = bar->cp->screeny - mheight;
+         *y = bar->cp->screeny - mheight;
       }
-      x -= mwidth / 2;
+      *x -= mwidth / 2;
    } else {
       if(bar->cp->screenx + bar->cp->width / 2 < sp->x + sp->width / 2) {
-         x = bar->cp->screenx + bar->cp->width;
+         *x = bar->cp->screenx + bar->cp->width;
       } else {
-         x = bar->cp->screenx - mwidth;
+         *x = bar->cp->screenx - mwidth;
       }
-      y = bar->cp->screeny + np->y;
+      *y = bar->cp->screeny + np->y;
    }
 
-   ShowWindowMenu(np->client, x, y);
-
 }
 
 /** Add a client to the task bar. */
@@ -314,6 +512,11 @@ void AddClientToTaskBar(ClientNode *np)
 
    tp = Allocate(sizeof(Node));
    tp->client = np;
+   tp->group = GetGroup(np->className);
+   tp->group->count += 1;
+   tp->button = -1;
+   tp->visible = 0;
+   XSaveContext(display, np->window, nodeContext, (void*)tp);
 
    if(settings.taskInsertMode == INSERT_RIGHT) {
       tp->next = NULL;
@@ -335,6 +538,7 @@ void AddClientToTaskBar(ClientNode *np)
          taskBarNodesTail = tp;
       }
    }
+   SetNodeVisible(tp, ShouldFocus(np));
 
    UpdateTaskBar();
    UpdateNetClientList();
@@ -345,25 +549,38 @@ void AddClientToTaskBar(ClientNode *np)
 void RemoveClientFromTaskBar(ClientNode *np)
 {
 
+   TaskBarType *bp;
    Node *tp;
+   unsigned int i;
 
    Assert(np);
 
-   for(tp = taskBarNodes; tp; tp = tp->next) {
-      if(tp->client == np) {
-         if(tp->prev) {
-            tp->prev->next = tp->next;
-         } else {
-            taskBarNodes = tp->next;
-         }
-         if(tp->next) {
-            tp->next->prev = tp->prev;
-         } else {
-            taskBarNodesTail = tp->prev;
+   if(!XFindContext(display, np->window, nodeContext, (void*)&tp)) {
+      XDeleteContext(display, np->window, nodeContext);
+      for(bp = bars; bp; bp = bp->next) {
+         for(i = 0; i < bp->buttonCount; i++) {
+            if(bp->buttons[i].node == tp) {
+               bp->buttons[i].node = NULL;
+               break;
+            }
          }
-         Release(tp);
-         break;
       }
+      SetNodeVisible(tp, 0);
+      if(tp->prev) {
+         tp->prev->next = tp->next;
+      } else {
+         taskBarNodes = tp->next;
+      }
+      if(tp->next) {
+         tp->next->prev = tp->prev;
+      } else {
+         taskBarNodesTail = tp->prev;
+      }
+      tp->group->count -= 1;
+      if(tp->group->count == 0) {
+         ReleaseGroup(tp->group);
+      }
+      Release(tp);
    }
 
    UpdateTaskBar();
@@ -386,7 +603,7 @@ void UpdateTaskBar(void)
       if(bp->layout == LAYOUT_VERTICAL) {
          lastHeight = bp->cp->requestedHeight;
          bp->cp->requestedHeight = GetStringHeight(FONT_TASK) + 12;
-         bp->cp->requestedHeight *= GetItemCount();
+         bp->cp->requestedHeight *= GetItemCount(bp);
          bp->cp->requestedHeight += 2;
          if(lastHeight != bp->cp->requestedHeight) {
             ResizeTray(bp->cp->tray);
@@ -413,7 +630,11 @@ void SignalTaskbar(const TimeType *now, int x, int y, Window w, void *data)
          } else {
             np = GetNode(bp, y - bp->cp->screeny);
          }
-         if(np && np->client->name) {
+         if(np && bp->grouped && np->group->visible > 1) {
+            if(np->group->name) {
+               ShowPopup(x, y, np->group->name);
+            }
+         } else if(np && np->client->name) {
             ShowPopup(x, y, np->client->name);
          }
       }
@@ -421,19 +642,22 @@ void SignalTaskbar(const TimeType *now, int x, int y, Window w, void *data)
 
 }
 
-/** Draw a specific task bar. */
-void Render(const TaskBarType *bp)
+/** Draw a specific task bar.
+ * Buttons are kept rendered in pixmaps and only buttons that changed
+ * are rendered again. Only the area that changed is copied to the tray.
+ */
+void Render(TaskBarType *bp)
 {
 
-   Node *tp;
-   ButtonNode button;
+   TaskButtonType *old;
+   TaskButtonType *temp;
    int x, y;
    int remainder;
    int itemWidth, itemCount;
-   int width;
-   Pixmap buffer;
-   GC gc;
-   char *minimizedName;
+   int extent;
+   int damageStart, damageStop;
+   unsigned int count;
+   unsigned int i;
 
    if(JUNLIKELY(shouldExit)) {
       return;
@@ -442,100 +666,295 @@ void Render(const TaskBarType *bp)
    Assert(bp);
    Assert(bp->cp);
 
-   width = bp->cp->width;
-   buffer = bp->cp->pixmap;
-   gc = rootGC;
-
-   x = 0;
-   width -= x;
-   y = 0;
-
-   ClearTrayDrawable(bp->cp);
-
-   itemCount = GetItemCount();
-   if(!itemCount) {
-      UpdateSpecificTray(bp->cp->tray, bp->cp);
+   if(JUNLIKELY(bp->buffer == None)) {
       return;
    }
+
+   if(visibleDirty) {
+      UpdateVisibleNodes();
+   }
+
+   itemCount = GetItemCount(bp);
    if(bp->layout == LAYOUT_HORIZONTAL) {
       itemWidth = GetItemWidth(bp, itemCount);
-      remainder = width - itemWidth * itemCount;
+      remainder = bp->cp->width - itemWidth * itemCount;
    } else {
-      itemWidth = width;
+      itemWidth = bp->cp->width;
       remainder = 0;
    }
+   bp->itemWidth = itemWidth;
+   bp->remainder = remainder;
 
-   ResetButton(&button, buffer, &rootVisual);
-   button.font = FONT_TASK;
+   if(scratchButtonMax < itemCount) {
+      if(scratchButtons) {
+         Release(scratchButtons);
+      }
+      scratchButtonMax = itemCount;
+      scratchButtons = Allocate(scratchButtonMax * sizeof(TaskButtonType));
+   }
 
-   for(tp = taskBarNodes; tp; tp = tp->next) {
-      if(ShouldFocus(tp->client)) {
+   /* Mark items that already have a button. */
+   old = bp->buttons;
+   for(i = 0; i < bp->buttonCount; i++) {
+      if(old[i].node) {
+         old[i].node->button = i;
+      }
+   }
 
-         tp->y = y;
+   /* Get the buttons to show, reusing rendered buttons if possible. */
+   for(count = 0; count < itemCount; count++) {
 
-         if(tp->client->state.status & (STAT_ACTIVE | STAT_FLASH)) {
-            button.type = BUTTON_TASK_ACTIVE;
-         } else {
-            button.type = BUTTON_TASK;
-         }
+      Node *tp = bp->grouped ? visibleGroups[count]->node
+                             : visibleNodes[count];
+      TaskButtonType *button = &scratchButtons[count];
 
+      if(tp->button >= 0) {
+         *button = old[tp->button];
+         old[tp->button].node = NULL;
+         old[tp->button].pixmap = None;
+         old[tp->button].name = NULL;
+         tp->button = -1;
+      } else {
+         button->node = tp;
+         button->pixmap = None;
+         button->name = NULL;
+      }
+
+   }
+
+   /* Release buttons that are no longer shown. */
+   for(i = 0; i < bp->buttonCount; i++) {
+      if(old[i].node) {
+         old[i].node->button = -1;
+      }
+      ReleaseButton(&old[i]);
+   }
+   temp = bp->buttons;
+   bp->buttons = scratchButtons;
+   bp->buttonCount = count;
+   scratchButtons = temp;
+   i = bp->buttonMax;
+   bp->buttonMax = scratchButtonMax;
+   scratchButtonMax = i;
+
+   /* Render buttons that changed and copy buttons that moved. */
+   damageStart = INT_MAX;
+   damageStop = 0;
+   x = 0;
+   y = 0;
+   for(i = 0; i < bp->buttonCount; i++) {
+
+      TaskButtonType *button = &bp->buttons[i];
+      const ClientNode *np = button->node->client;
+      const unsigned int itemTotal = bp->grouped
+                                   ? button->node->group->visible : 1;
+      const char *name = itemTotal > 1 ? button->node->group->name
+                                       : np->name;
+      const char minimized = (np->state.status & STAT_MINIMIZED) ? 1 : 0;
+      const unsigned int iconSerial = np->icon ? np->icon->serial : 0;
+      ButtonType type;
+      int width, height;
+      int offset;
+      const int bx = x;
+      const int by = y;
+
+      if(np->state.status & (STAT_ACTIVE | STAT_FLASH)) {
+         type = BUTTON_TASK_ACTIVE;
+      } else {
+         type = BUTTON_TASK;
+      }
+      /* Determine the location and size of the button. */
+      button->node->y = y;
+      if(bp->layout == LAYOUT_HORIZONTAL) {
+         offset = x;
+         width = itemWidth;
+         height = bp->cp->height;
          if(remainder) {
-            button.width = itemWidth;
-         } else {
-            button.width = itemWidth - 1;
-         }
-         button.height = bp->itemHeight;
-         button.x = x;
-         button.y = y;
-         button.icon = tp->client->icon;
-
-         if(tp->client->state.status & STAT_MINIMIZED) {
-            if(tp->client->name) {
-               minimizedName = AllocateStack(strlen(tp->client->name) + 3);
-               sprintf(minimizedName, "[%s]", tp->client->name);
-               button.text = minimizedName;
-               DrawButton(&button);
-               ReleaseStack(minimizedName);
-            } else {
-               button.text = "[]";
-               DrawButton(&button);
-            }
-         } else {
-            button.text = tp->client->name;
-            DrawButton(&button);
+            width += 1;
+            remainder -= 1;
          }
+         x += width;
+      } else {
+         offset = y;
+         width = bp->cp->width;
+         height = bp->itemHeight;
+         y += height;
+      }
 
-         if(tp->client->state.status & STAT_MINIMIZED) {
-            const int isize = (bp->itemHeight + 7) / 8;
-            int i;
-            JXSetForeground(display, gc, colors[COLOR_TASK_FG]);
-            for(i = 0; i <= isize; i++) {
-               const int xc = x + i + 3;
-               const int y1 = bp->itemHeight - 3 - isize + i;
-               const int y2 = bp->itemHeight - 3;
-               JXDrawLine(display, buffer, gc, xc, y1, xc, y2);
-            }
+      if(   button->pixmap == None || !bp->valid
+         || button->type != type || button->minimized != minimized
+         || button->icon != np->icon || button->iconSerial != iconSerial
+         || button->count != itemTotal
+         || !IsSameName(button->name, name)
+         || button->width != width || button->height != height
+         || (bp->layout == LAYOUT_VERTICAL && button->y != by)) {
+         button->x = bx;
+         button->y = by;
+         button->width = width;
+         button->height = height;
+         button->type = type;
+         button->minimized = minimized;
+         button->icon = np->icon;
+         button->iconSerial = iconSerial;
+         button->count = itemTotal;
+         if(button->name) {
+            Release(button->name);
          }
+         button->name = name ? CopyString(name) : NULL;
+         RenderButton(bp, button);
+      } else if(button->x == bx && button->y == by) {
+         continue;
+      }
+      button->x = bx;
+      button->y = by;
 
-         if(bp->layout == LAYOUT_HORIZONTAL) {
-            x += itemWidth;
-            if(remainder) {
-               x += 1;
-               remainder -= 1;
-            }
-         } else {
-            y += bp->itemHeight;
-            if(remainder) {
-               y += 1;
-               remainder -= 1;
-            }
-         }
+      JXCopyArea(display, button->pixmap, bp->buffer, rootGC, 0, 0,
+                 width, height, bx, by);
+      damageStart = Min(damageStart, offset);
+      damageStop = Max(damageStop, offset + width);
+
+   }
 
+   /* Clear the space that is no longer used. */
+   if(bp->layout == LAYOUT_HORIZONTAL) {
+      extent = x;
+   } else {
+      extent = y;
+   }
+   if(!bp->valid) {
+      bp->extent = bp->layout == LAYOUT_HORIZONTAL
+                 ? bp->cp->width : bp->cp->height;
+   }
+   if(extent < bp->extent) {
+      if(bp->layout == LAYOUT_HORIZONTAL) {
+         JXCopyArea(display, bp->background, bp->buffer, rootGC,
+                    extent, 0, bp->extent - extent, bp->cp->height,
+                    extent, 0);
+      } else {
+         JXCopyArea(display, bp->background, bp->buffer, rootGC,
+                    0, extent, bp->cp->width, bp->extent - extent,
+                    0, extent);
       }
+      damageStart = Min(damageStart, extent);
+      damageStop = Max(damageStop, bp->extent);
    }
+   bp->extent = extent;
+   bp->valid = 1;
+
+   /* Copy the changed area to the tray. */
+   if(damageStart < damageStop) {
+      if(bp->layout == LAYOUT_HORIZONTAL) {
+         UpdateSpecificTrayArea(bp->cp->tray, bp->cp, damageStart, 0,
+                                damageStop - damageStart, bp->cp->height);
+      } else {
+         UpdateSpecificTrayArea(bp->cp->tray, bp->cp, 0, damageStart,
+                                bp->cp->width, damageStop - damageStart);
+      }
+   }
+
+}
 
-   UpdateSpecificTray(bp->cp->tray, bp->cp);
+/** Render a task bar button to its pixmap. */
+void RenderButton(const TaskBarType *bp, TaskButtonType *button)
+{
+
+   ButtonNode node;
+   char *minimizedName;
+   int width;
 
+   if(button->pixmap != None) {
+      JXFreePixmap(display, button->pixmap);
+   }
+   button->pixmap = JXCreatePixmap(display, rootWindow, button->width,
+                                   button->height, rootVisual.depth);
+   JXCopyArea(display, bp->background, button->pixmap, rootGC,
+              button->x, button->y, button->width, button->height, 0, 0);
+
+   /* Leave a pixel between buttons in horizontal layout. */
+   width = button->width;
+   if(bp->layout == LAYOUT_HORIZONTAL) {
+      width -= 1;
+   }
+
+   ResetButton(&node, button->pixmap, &rootVisual);
+   node.font = FONT_TASK;
+   node.type = button->type;
+   node.width = width;
+   node.height = bp->itemHeight;
+   node.x = 0;
+   node.y = 0;
+   node.icon = button->node->client->icon;
+
+   if(button->minimized) {
+      if(button->name) {
+         minimizedName = AllocateStack(strlen(button->name) + 3);
+         sprintf(minimizedName, "[%s]", button->name);
+         node.text = minimizedName;
+         DrawButton(&node);
+         ReleaseStack(minimizedName);
+      } else {
+         node.text = "[]";
+         DrawButton(&node);
+      }
+   } else {
+      node.text = button->name;
+      DrawButton(&node);
+   }
+
+   if(button->minimized) {
+      const int isize = (bp->itemHeight + 7) / 8;
+      int i;
+      JXSetForeground(display, rootGC, colors[COLOR_TASK_FG]);
+      for(i = 0; i <= isize; i++) {
+         const int xc = i + 3;
+         const int y1 = bp->itemHeight - 3 - isize + i;
+         const int y2 = bp->itemHeight - 3;
+         JXDrawLine(display, button->pixmap, rootGC, xc, y1, xc, y2);
+      }
+   }
+
+   /* Show the number of clients in a group. */
+   if(button->count > 1) {
+      char str[16];
+      int bwidth, bheight;
+      int bx, by;
+      snprintf(str, sizeof(str), "%u", button->count);
+      bwidth = GetStringWidth(FONT_TASK, str) + 4;
+      bheight = GetStringHeight(FONT_TASK);
+      bx = width - bwidth - 3;
+      by = (bp->itemHeight - bheight) / 2;
+      if(bx > 0) {
+         JXSetForeground(display, rootGC, colors[COLOR_TASK_FG]);
+         JXFillRectangle(display, button->pixmap, rootGC,
+                         bx, by, bwidth, bheight);
+         RenderString(&rootVisual, button->pixmap, FONT_TASK,
+                      COLOR_TASK_BG1, bx + 2, by, bwidth - 2, str);
+      }
+   }
+
+}
+
+/** Release the resources used by a task bar button. */
+void ReleaseButton(TaskButtonType *button)
+{
+   if(button->pixmap != None) {
+      JXFreePixmap(display, button->pixmap);
+      button->pixmap = None;
+   }
+   if(button->name) {
+      Release(button->name);
+      button->name = NULL;
+   }
+}
+
+/** Determine if two (possibly NULL) names are the same. */
+char IsSameName(const char *a, const char *b)
+{
+   if(a && b) {
+      return !strcmp(a, b);
+   } else {
+      return a == b;
+   }
 }
 
 /** Focus the next client in the task bar. */
@@ -616,66 +1035,196 @@ void FocusPrevious(void)
 Node *GetNode(TaskBarType *bar, int x)
 {
 
-   Node *tp;
-   int index, stop;
+   unsigned int index;
 
-   index = 0;
-   if(bar->layout == LAYOUT_HORIZONTAL) {
+   if(x < 0) {
+      return NULL;
+   }
 
-      const int width = bar->cp->width - index; 
-      const unsigned int itemCount = GetItemCount();
-      const int itemWidth = GetItemWidth(bar, itemCount);
-      int remainder = width - itemWidth * itemCount;
+   if(bar->layout == LAYOUT_HORIZONTAL) {
 
-      for(tp = taskBarNodes; tp; tp = tp->next) {
-         if(ShouldFocus(tp->client)) {
-            if(remainder) {
-               stop = index + itemWidth + 1;
-               remainder -= 1;
-            } else {
-               stop = index + itemWidth;
-            }
-            if(x >= index && x < stop) {
-               return tp;
-            }
-            index = stop;
-         }
+      /* The first "remainder" items are one pixel wider. */
+      const int wide = bar->remainder * (bar->itemWidth + 1);
+      if(bar->itemWidth <= 0) {
+         return NULL;
+      }
+      if(x < wide) {
+         index = x / (bar->itemWidth + 1);
+      } else {
+         index = bar->remainder + (x - wide) / bar->itemWidth;
       }
 
    } else {
 
-      for(tp = taskBarNodes; tp; tp = tp->next) {
-         if(ShouldFocus(tp->client)) {
-            stop = index + bar->itemHeight;
-            if(x >= index && x < stop) {
-               return tp;
-            }
-            index = stop;
-         }
+      if(bar->itemHeight <= 0) {
+         return NULL;
       }
+      index = x / bar->itemHeight;
 
    }
 
+   if(index < bar->buttonCount) {
+      return bar->buttons[index].node;
+   }
    return NULL;
 
 }
 
-/** Get the number of items on the task bar. */
-unsigned int GetItemCount(void)
+/** Get the number of items on a task bar. */
+unsigned int GetItemCount(const TaskBarType *bp)
+{
+   return bp->grouped ? visibleGroupCount : visibleCount;
+}
+
+/** Update the list of items shown on the task bar.
+ * The counts are maintained by SetNodeVisible, this only restores the order.
+ */
+void UpdateVisibleNodes(void)
 {
 
    Node *tp;
-   unsigned int count;
+   GroupType *gp;
 
-   count = 0;
+   if(visibleCount > visibleMax) {
+      visibleMax = visibleCount * 2;
+      if(visibleNodes) {
+         Release(visibleNodes);
+      }
+      visibleNodes = Allocate(visibleMax * sizeof(Node*));
+   }
+   if(visibleGroupCount > visibleGroupMax) {
+      visibleGroupMax = visibleGroupCount * 2;
+      if(visibleGroups) {
+         Release(visibleGroups);
+      }
+      visibleGroups = Allocate(visibleGroupMax * sizeof(GroupType*));
+   }
+
+   for(gp = groups; gp; gp = gp->next) {
+      gp->node = NULL;
+   }
+
+   visibleDirty = 0;
+   visibleCount = 0;
+   visibleGroupCount = 0;
    for(tp = taskBarNodes; tp; tp = tp->next) {
-      if(ShouldFocus(tp->client)) {
-         count += 1;
+      if(tp->visible) {
+
+         /* Groups are shown in the order of their first item and
+          * represented by the active item if there is one. */
+         gp = tp->group;
+         if(gp->node == NULL) {
+            visibleGroups[visibleGroupCount] = gp;
+            visibleGroupCount += 1;
+            gp->node = tp;
+         } else if(tp->client->state.status & STAT_ACTIVE) {
+            gp->node = tp;
+         }
+
+         visibleNodes[visibleCount] = tp;
+         visibleCount += 1;
+
+      }
+   }
+
+}
+
+/** Show or hide a task bar item. */
+void SetNodeVisible(Node *tp, char visible)
+{
+   if(tp->visible != visible) {
+      tp->visible = visible;
+      if(visible) {
+         if(tp->group->visible == 0) {
+            visibleGroupCount += 1;
+         }
+         tp->group->visible += 1;
+         visibleCount += 1;
+      } else {
+         tp->group->visible -= 1;
+         if(tp->group->visible == 0) {
+            visibleGroupCount -= 1;
+         }
+         visibleCount -= 1;
+      }
+      visibleDirty = 1;
+   }
+}
+
+/** Update the task bar item of a client after its state changes. */
+void UpdateTaskBarClient(const ClientNode *np)
+{
+
+   Node *tp;
+   GroupType *gp;
+
+   if(np == NULL) {
+      for(tp = taskBarNodes; tp; tp = tp->next) {
+         SetNodeVisible(tp, ShouldFocus(tp->client));
+      }
+      return;
+   }
+
+   if(XFindContext(display, np->window, nodeContext, (void*)&tp)) {
+      return;
+   }
+   SetNodeVisible(tp, ShouldFocus(np));
+
+   /* Keep the active item as the item shown for its group. */
+   gp = tp->group;
+   if(!visibleDirty && tp->visible && gp->visible > 1) {
+      if(np->state.status & STAT_ACTIVE) {
+         gp->node = tp;
+      } else if(gp->node == tp) {
+         visibleDirty = 1;
+      }
+   }
+
+}
+
+/** Get the group for a window class, creating it if needed. */
+GroupType *GetGroup(const char *name)
+{
+
+   GroupType *gp;
+
+   for(gp = groups; gp; gp = gp->next) {
+      if(IsSameName(gp->name, name)) {
+         return gp;
       }
    }
 
-   return count;
+   gp = Allocate(sizeof(GroupType));
+   gp->name = name ? CopyString(name) : NULL;
+   gp->count = 0;
+   gp->visible = 0;
+   gp->node = NULL;
+   gp->prev = NULL;
+   gp->next = groups;
+   if(groups) {
+      groups->prev = gp;
+   }
+   groups = gp;
+
+   return gp;
+
+}
 
+/** Remove an empty group. */
+void ReleaseGroup(GroupType *gp)
+{
+   if(gp->prev) {
+      gp->prev->next = gp->next;
+   } else {
+      groups = gp->next;
+   }
+   if(gp->next) {
+      gp->next->prev = gp->prev;
+   }
+   if(gp->name) {
+      Release(gp->name);
+   }
+   Release(gp);
 }
 
 /** Get the width of an item in the task bar. */
@@ -723,6 +1272,15 @@ void SetMaxTaskBarItemWidth(TrayComponentType *cp, const char *value)
 
 }
 
+/** Set whether a task bar groups items by window class. */
+void SetTaskBarGrouped(TrayComponentType *cp, char grouped)
+{
+   TaskBarType *bp;
+   Assert(cp);
+   bp = (TaskBarType*)cp->object;
+   bp->grouped = grouped;
+}
+
 /** Maintain the _NET_CLIENT_LIST[_STACKING] properties on the root. */
 void UpdateNetClientList(void)
 {
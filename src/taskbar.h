@@ -33,6 +33,13 @@ void AddClientToTaskBar(struct ClientNode *np);
  */
 void RemoveClientFromTaskBar(struct ClientNode *np);
 
+/** Update the task bar item of a client after its state changes.
+ * This should be called when a client is mapped, minimized, restored,
+ * withdrawn, or focused, or when its desktop, owner, or list state changes.
+ * @param np The client or NULL to check all clients.
+ */
+void UpdateTaskBarClient(const struct ClientNode *np);
+
 /** Update all task bars. */
 void UpdateTaskBar(void);
 
@@ -48,6 +55,12 @@ void FocusPrevious(void);
  */
 void SetMaxTaskBarItemWidth(struct TrayComponentType *cp, const char *value);
 
+/** Set whether task bar items are grouped by window class.
+ * @param cp The task bar component.
+ * @param grouped 1 to show one button per window class, 0 otherwise.
+ */
+void SetTaskBarGrouped(struct TrayComponentType *cp, char grouped);
+
 /** Update the _NET_CLIENT_LIST property. */
 void UpdateNetClientList(void);
 
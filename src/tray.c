@@ -22,15 +22,23 @@
 #include "event.h"
 #include "client.h"
 #include "misc.h"
+#include "place.h"
+#include "move.h"
 
 #define DEFAULT_TRAY_WIDTH 32
 #define DEFAULT_TRAY_HEIGHT 32
 
+/** Time in milliseconds before hiding a tray after the mouse leaves. */
+#define TRAY_HIDE_DELAY 100
+
 static TrayType *trays;
 static unsigned int trayCount;
 
 static void HandleTrayExpose(TrayType *tp, const XExposeEvent *event);
 static void HandleTrayEnterNotify(TrayType *tp, const XCrossingEvent *event);
+static void HandleTrayLeaveNotify(TrayType *tp, const XCrossingEvent *event);
+static void StartTrayHide(TrayType *tp);
+static void CancelTrayHide(TrayType *tp);
 
 static TrayComponentType *GetTrayComponent(TrayType *tp, int x, int y);
 static void HandleTrayButtonPress(TrayType *tp, const XButtonEvent *event);
@@ -46,6 +54,8 @@ static char CheckHorizontalFill(TrayType *tp);
 static char CheckVerticalFill(TrayType *tp);
 static void LayoutTray(TrayType *tp, int *variableSize,
                        int *variableRemainder);
+static void CreateTrayPixmap(TrayType *tp);
+static void DamageTray(TrayType *tp, int x, int y, int width, int height);
 
 static void SignalTray(const TimeType *now, int x, int y, Window w,
                        void *data);
@@ -92,6 +102,7 @@ void StartupTray(void)
          | KeyPressMask
          | KeyReleaseMask
          | EnterWindowMask
+         | LeaveWindowMask
          | PointerMotionMask;
 
       attrMask |= CWBackPixel;
@@ -117,6 +128,7 @@ void StartupTray(void)
       }
 
       SetDefaultCursor(tp->window);
+      CreateTrayPixmap(tp);
 
       /* Create and layout items on the tray. */
       xoffset = 0;
@@ -172,6 +184,9 @@ void StartupTray(void)
 
       trayCount += 1;
 
+      /* Hide the tray if the mouse isn't on it. */
+      StartTrayHide(tp);
+
    }
 
    UpdatePager();
@@ -192,6 +207,15 @@ void ShutdownTray(void)
             (cp->Destroy)(cp);
          }
       }
+      JXFreePixmap(display, tp->pixmap);
+      tp->pixmap = None;
+      tp->damageCount = 0;
+      CancelTrayHide(tp);
+      if(tp->trigger != None) {
+         JXDestroyWindow(display, tp->trigger);
+         tp->trigger = None;
+      }
+      tp->hidden = 0;
       JXDestroyWindow(display, tp->window);
    }
 
@@ -206,7 +230,6 @@ void DestroyTray(void)
 
    while(trays) {
       tp = trays->next;
-      UnregisterCallback(SignalTray, trays);
       while(trays->components) {
          cp = trays->components->next;
          Release(trays->components);
@@ -242,8 +265,14 @@ TrayType *CreateTray(void)
 
    tp->autoHide = THIDE_OFF;
    tp->hidden = 0;
+   tp->hidePending = 0;
+   tp->leaveTime.seconds = 0;
+   tp->leaveTime.ms = 0;
 
    tp->window = None;
+   tp->trigger = None;
+   tp->pixmap = None;
+   tp->damageCount = 0;
 
    tp->components = NULL;
    tp->componentsTail = NULL;
@@ -251,8 +280,6 @@ TrayType *CreateTray(void)
    tp->next = trays;
    trays = tp;
 
-   RegisterCallback(100, SignalTray, tp);
-
    return tp;
 
 }
@@ -584,12 +611,17 @@ void ShowTray(TrayType *tp)
    if(tp->hidden) {
 
       tp->hidden = 0;
+      InvalidateSnapIndex();
+      JXUnmapWindow(display, tp->trigger);
       JXMoveWindow(display, tp->window, tp->x, tp->y);
 
       JXQueryPointer(display, rootWindow, &win1, &win2,
                      &mousex, &mousey, &winx, &winy, &mask);
       SetMousePosition(mousex, mousey, win2);
 
+      /* This is canceled when the mouse enters the tray. */
+      StartTrayHide(tp);
+
    }
 
 }
@@ -614,8 +646,11 @@ void ShowAllTrays(void)
 void HideTray(TrayType *tp)
 {
 
+   XSetWindowAttributes attr;
    const ScreenType *sp;
    int x, y;
+   int tx, ty;
+   int twidth, theight;
 
    /* Don't hide if the tray is raised. */
    if(tp->autoHide & THIDE_RAISED) {
@@ -623,35 +658,65 @@ void HideTray(TrayType *tp)
    }
 
    tp->hidden = 1;
+   InvalidateSnapIndex();
 
-   /* Determine where to move the tray. */
+   /* Determine where to move the tray and where to show it from. */
    sp = GetCurrentScreen(tp->x, tp->y);
    switch(tp->autoHide) {
    case THIDE_LEFT:
-      x = sp->y - tp->width - TRAY_BORDER_SIZE;
+      x = sp->x - tp->width - TRAY_BORDER_SIZE;
       y = tp->y;
+      tx = sp->x;
+      ty = tp->y;
+      twidth = 1;
+      theight = tp->height + 2 * TRAY_BORDER_SIZE;
       break;
    case THIDE_RIGHT:
-      x = sp->y + sp->width - TRAY_BORDER_SIZE;
+      x = sp->x + sp->width - TRAY_BORDER_SIZE;
       y = tp->y;
+      tx = sp->x + sp->width - 1;
+      ty = tp->y;
+      twidth = 1;
+      theight = tp->height + 2 * TRAY_BORDER_SIZE;
       break;
    case THIDE_TOP:
       x = tp->x;
       y = sp->y - tp->height - TRAY_BORDER_SIZE;
+      tx = tp->x;
+      ty = sp->y;
+      twidth = tp->width + 2 * TRAY_BORDER_SIZE;
+      theight = 1;
       break;
    case THIDE_BOTTOM:
       x = tp->x;
       y = sp->y + sp->height - TRAY_BORDER_SIZE;
+      tx = tp->x;
+      ty = sp->y + sp->height - 1;
+      twidth = tp->width + 2 * TRAY_BORDER_SIZE;
+      theight = 1;
       break;
    default:
       Assert(0);
-      break;
+      return;
    }
 
    /* Move and redraw. */
    JXMoveWindow(display, tp->window, x, y);
    DrawSpecificTray(tp);
 
+   /* Show the tray again when the mouse reaches the edge. */
+   if(tp->trigger == None) {
+      attr.override_redirect = True;
+      attr.event_mask = EnterWindowMask;
+      tp->trigger = JXCreateWindow(display, rootWindow, tx, ty,
+                                   twidth, theight, 0, CopyFromParent,
+                                   InputOnly, CopyFromParent,
+                                   CWOverrideRedirect | CWEventMask, &attr);
+   } else {
+      JXMoveResizeWindow(display, tp->trigger, tx, ty, twidth, theight);
+   }
+   JXMapRaised(display, tp->trigger);
+
 }
 
 /** Process a tray event. */
@@ -661,6 +726,12 @@ char ProcessTrayEvent(const XEvent *event)
    TrayType *tp;
 
    for(tp = trays; tp; tp = tp->next) {
+      if(event->xany.window == tp->trigger && tp->trigger != None) {
+         if(event->type == EnterNotify) {
+            ShowTray(tp);
+         }
+         return 1;
+      }
       if(event->xany.window == tp->window) {
          switch(event->type) {
          case Expose:
@@ -669,6 +740,9 @@ char ProcessTrayEvent(const XEvent *event)
          case EnterNotify:
             HandleTrayEnterNotify(tp, &event->xcrossing);
             return 1;
+         case LeaveNotify:
+            HandleTrayLeaveNotify(tp, &event->xcrossing);
+            return 1;
          case ButtonPress:
             HandleTrayButtonPress(tp, &event->xbutton);
             return 1;
@@ -688,28 +762,70 @@ char ProcessTrayEvent(const XEvent *event)
 
 }
 
-/** Signal the tray (needed for autohide). */
+/** Signal the tray to hide after the mouse leaves (for autohide). */
 void SignalTray(const TimeType *now, int x, int y, Window w, void *data)
 {
+
    TrayType *tp = (TrayType*)data;
-   if(tp->autoHide != THIDE_OFF && !tp->hidden && !menuShown) {
+
+   /* Callbacks run right away when registered, so check the delay.
+    * If a menu is open, try again later. */
+   if(   GetTimeDifference(now, &tp->leaveTime) < TRAY_HIDE_DELAY
+      || menuShown) {
+      return;
+   }
+
+   CancelTrayHide(tp);
+   if(!tp->hidden) {
       if(x < tp->x || x >= tp->x + tp->width
          || y < tp->y || y >= tp->y + tp->height) {
          HideTray(tp);
       }
    }
+
+}
+
+/** Start the timer to hide a tray (for autohide). */
+void StartTrayHide(TrayType *tp)
+{
+   if(   tp->autoHide != THIDE_OFF && !(tp->autoHide & THIDE_RAISED)
+      && !tp->hidden) {
+      GetCurrentTime(&tp->leaveTime);
+      if(!tp->hidePending) {
+         tp->hidePending = 1;
+         RegisterCallback(TRAY_HIDE_DELAY, SignalTray, tp);
+      }
+   }
+}
+
+/** Stop the timer to hide a tray. */
+void CancelTrayHide(TrayType *tp)
+{
+   if(tp->hidePending) {
+      tp->hidePending = 0;
+      UnregisterCallback(SignalTray, tp);
+   }
 }
 
 /** Handle a tray expose event. */
 void HandleTrayExpose(TrayType *tp, const XExposeEvent *event)
 {
-   DrawSpecificTray(tp);
+   DamageTray(tp, event->x, event->y, event->width, event->height);
 }
 
 /** Handle a tray enter notify (for autohide). */
 void HandleTrayEnterNotify(TrayType *tp, const XCrossingEvent *event)
 {
    ShowTray(tp);
+   CancelTrayHide(tp);
+}
+
+/** Handle a tray leave notify (for autohide). */
+void HandleTrayLeaveNotify(TrayType *tp, const XCrossingEvent *event)
+{
+   if(event->detail != NotifyInferior) {
+      StartTrayHide(tp);
+   }
 }
 
 /** Get the tray component under the given coordinates. */
@@ -814,7 +930,7 @@ void DrawTray(void)
 }
 
 /** Draw a specific tray. */
-void DrawSpecificTray(const TrayType *tp)
+void DrawSpecificTray(TrayType *tp)
 {
 
    TrayComponentType *cp;
@@ -842,26 +958,128 @@ void LowerTrays(void)
    TrayType *tp;
    for(tp = trays; tp; tp = tp->next) {
       tp->autoHide &= ~THIDE_RAISED;
+      StartTrayHide(tp);
    }
    RestackClients();
 }
 
 /** Update a specific component on a tray. */
-void UpdateSpecificTray(const TrayType *tp, const TrayComponentType *cp)
+void UpdateSpecificTray(TrayType *tp, const TrayComponentType *cp)
+{
+   UpdateSpecificTrayArea(tp, cp, 0, 0, cp->width, cp->height);
+}
+
+/** Update part of a specific component on a tray. */
+void UpdateSpecificTrayArea(TrayType *tp, const TrayComponentType *cp,
+                            int x, int y, int width, int height)
 {
 
    if(JUNLIKELY(shouldExit)) {
       return;
    }
 
-   /* If the tray is hidden, draw only the background. */
-   if(!tp->hidden && cp->pixmap != None) {
-      JXCopyArea(display, cp->pixmap, tp->window, rootGC, 0, 0,
-                 cp->width, cp->height, cp->x, cp->y);
+   if(   tp->pixmap != None && cp->pixmap != None
+      && width > 0 && height > 0) {
+      JXCopyArea(display, cp->pixmap, tp->pixmap, rootGC, x, y,
+                 width, height, cp->x + x, cp->y + y);
+      DamageTray(tp, cp->x + x, cp->y + y, width, height);
    }
 
 }
 
+/** Add an area to the damage list of a tray. */
+void DamageTray(TrayType *tp, int x, int y, int width, int height)
+{
+
+   XRectangle *rp;
+   unsigned int i;
+   int x1, y1, x2, y2;
+
+   x1 = x;
+   y1 = y;
+   x2 = x + width;
+   y2 = y + height;
+
+   /* Merge with an area that overlaps or touches this one.
+    * If the list is full, collapse everything into one area. */
+   for(i = 0; i < tp->damageCount; i++) {
+      rp = &tp->damage[i];
+      if(   x1 <= rp->x + rp->width && rp->x <= x2
+         && y1 <= rp->y + rp->height && rp->y <= y2) {
+         break;
+      }
+   }
+   if(i == tp->damageCount && tp->damageCount == TRAY_MAX_DAMAGE) {
+      for(i = 1; i < tp->damageCount; i++) {
+         rp = &tp->damage[i];
+         x1 = Min(x1, rp->x);
+         y1 = Min(y1, rp->y);
+         x2 = Max(x2, rp->x + rp->width);
+         y2 = Max(y2, rp->y + rp->height);
+      }
+      tp->damageCount = 1;
+      i = 0;
+   }
+
+   rp = &tp->damage[i];
+   if(i < tp->damageCount) {
+      x1 = Min(x1, rp->x);
+      y1 = Min(y1, rp->y);
+      x2 = Max(x2, rp->x + rp->width);
+      y2 = Max(y2, rp->y + rp->height);
+   } else {
+      tp->damageCount += 1;
+   }
+   rp->x = x1;
+   rp->y = y1;
+   rp->width = x2 - x1;
+   rp->height = y2 - y1;
+
+}
+
+/** Copy damaged areas of the trays from their backing stores. */
+void FlushTrayDamage(void)
+{
+
+   TrayType *tp;
+   unsigned int i;
+
+   if(JUNLIKELY(shouldExit)) {
+      return;
+   }
+
+   for(tp = trays; tp; tp = tp->next) {
+
+      /* If the tray is hidden, only the background is shown.
+       * It will be exposed again when shown. */
+      if(!tp->hidden) {
+         for(i = 0; i < tp->damageCount; i++) {
+            const XRectangle *rp = &tp->damage[i];
+            JXCopyArea(display, tp->pixmap, tp->window, rootGC,
+                       rp->x, rp->y, rp->width, rp->height,
+                       rp->x, rp->y);
+         }
+      }
+      tp->damageCount = 0;
+
+   }
+
+}
+
+/** Create the backing store for a tray. */
+void CreateTrayPixmap(TrayType *tp)
+{
+   if(tp->pixmap != None) {
+      JXFreePixmap(display, tp->pixmap);
+   }
+   tp->pixmap = JXCreatePixmap(display, tp->window, tp->width, tp->height,
+                               rootVisual.depth);
+   JXSetForeground(display, rootGC, colors[COLOR_TRAY_BG2]);
+   JXFillRectangle(display, tp->pixmap, rootGC, 0, 0,
+                   tp->width, tp->height);
+   tp->damageCount = 0;
+}
+
 /** Layout tray components on a tray. */
 void LayoutTray(TrayType *tp, int *variableSize, int *variableRemainder)
 {
@@ -940,20 +1158,53 @@ void ResizeTray(TrayType *tp)
 {
 
    TrayComponentType *cp;
+   int *oldSizes;
+   unsigned int count, index;
    int variableSize;
    int variableRemainder;
    int xoffset, yoffset;
    int width, height;
+   int oldx, oldy;
+   int oldWidth, oldHeight;
+   char redraw;
 
    Assert(tp);
 
+   /* Save the current component sizes since LayoutTray resets them. */
+   count = 0;
+   for(cp = tp->components; cp; cp = cp->next) {
+      count += 1;
+   }
+   oldSizes = AllocateStack(Max(1, count) * 2 * sizeof(int));
+   index = 0;
+   for(cp = tp->components; cp; cp = cp->next) {
+      oldSizes[index++] = cp->width;
+      oldSizes[index++] = cp->height;
+   }
+
+   oldx = tp->x;
+   oldy = tp->y;
+   oldWidth = tp->width;
+   oldHeight = tp->height;
    LayoutTray(tp, &variableSize, &variableRemainder);
 
-   /* Reposition items on the tray. */
+   /* If the tray changed size, everything must be drawn again. */
+   redraw = tp->width != oldWidth || tp->height != oldHeight;
+   if(redraw) {
+      CreateTrayPixmap(tp);
+   }
+
+   /* Reposition items on the tray.
+    * Only components that moved or changed size are updated. */
    xoffset = 0;
    yoffset = 0;
+   index = 0;
    for(cp = tp->components; cp; cp = cp->next) {
 
+      const int lastWidth = oldSizes[index++];
+      const int lastHeight = oldSizes[index++];
+      const char moved = cp->x != xoffset || cp->y != yoffset;
+
       cp->x = xoffset;
       cp->y = yoffset;
       cp->screenx = tp->x + xoffset;
@@ -983,28 +1234,43 @@ void ResizeTray(TrayType *tp)
          }
          cp->width = width;
          cp->height = height;
-         (cp->Resize)(cp);
+         if(width != lastWidth || height != lastHeight) {
+            (cp->Resize)(cp);
+         }
       }
 
-      if(cp->window != None) {
+      if(moved && cp->window != None) {
          JXMoveWindow(display, cp->window, xoffset, yoffset);
       }
 
+      if(   !redraw
+         && (moved || cp->width != lastWidth || cp->height != lastHeight)) {
+         UpdateSpecificTray(tp, cp);
+      }
+
       if(tp->layout == LAYOUT_HORIZONTAL) {
          xoffset += cp->width;
       } else {
          yoffset += cp->height;
       }
    }
+   ReleaseStack(oldSizes);
 
-   JXMoveResizeWindow(display, tp->window, tp->x, tp->y,
-                      tp->width, tp->height);
+   if(   tp->x != oldx || tp->y != oldy
+      || tp->width != oldWidth || tp->height != oldHeight) {
 
-   UpdateTaskBar();
-   DrawSpecificTray(tp);
+      JXMoveResizeWindow(display, tp->window, tp->x, tp->y,
+                         tp->width, tp->height);
+      SetWorkarea();
+      InvalidateSnapIndex();
+
+      if(redraw) {
+         DrawSpecificTray(tp);
+      }
+      if(tp->hidden) {
+         HideTray(tp);
+      }
 
-   if(tp->hidden) {
-      HideTray(tp);
    }
 
 }
@@ -11,10 +11,14 @@
 #define TRAY_H
 
 #include "hint.h"
+#include "timing.h"
 
 /* Size of the tray border. */
 #define TRAY_BORDER_SIZE   1
 
+/** Maximum number of damaged areas tracked per tray. */
+#define TRAY_MAX_DAMAGE    8
+
 /** Enumeration of tray layouts. */
 typedef unsigned char LayoutType;
 #define LAYOUT_HORIZONTAL  0  /**< Left-to-right. */
@@ -144,8 +148,16 @@ typedef struct TrayType {
 
    TrayAutoHideType  autoHide;
    char hidden;     /**< 1 if hidden (due to autohide), 0 otherwise. */
+   char hidePending;    /**< 1 if waiting to hide, 0 otherwise. */
+   TimeType leaveTime;  /**< Time the mouse left the tray. */
 
    Window window; /**< The tray window. */
+   Window trigger;   /**< Window to show the tray when hidden (or None). */
+   Pixmap pixmap; /**< Backing store for the tray window. */
+
+   /** Areas of the window to be copied from the backing store. */
+   XRectangle damage[TRAY_MAX_DAMAGE];
+   unsigned int damageCount;  /**< Number of damaged areas. */
 
    /** Start of the tray components. */
    struct TrayComponentType *components;
@@ -197,7 +209,7 @@ void DrawTray(void);
 /** Draw a specific tray.
  * @param tp The tray to draw.
  */
-void DrawSpecificTray(const TrayType *tp);
+void DrawSpecificTray(TrayType *tp);
 
 /** Raise tray windows. */
 void RaiseTrays(void);
@@ -206,10 +218,28 @@ void RaiseTrays(void);
 void LowerTrays(void);
 
 /** Update a component on a tray.
+ * The contents are copied to the backing store of the tray and the
+ * window is updated by FlushTrayDamage.
+ * @param tp The tray containing the component.
+ * @param cp The component that needs updating.
+ */
+void UpdateSpecificTray(TrayType *tp, const TrayComponentType *cp);
+
+/** Update part of a component on a tray.
  * @param tp The tray containing the component.
  * @param cp The component that needs updating.
+ * @param x The x-coordinate of the area within the component.
+ * @param y The y-coordinate of the area within the component.
+ * @param width The width of the area.
+ * @param height The height of the area.
+ */
+void UpdateSpecificTrayArea(TrayType *tp, const TrayComponentType *cp,
+                            int x, int y, int width, int height);
+
+/** Copy damaged areas of the trays from their backing stores.
+ * This is called once the pending events have been processed.
  */
-void UpdateSpecificTray(const TrayType *tp, const TrayComponentType *cp);
+void FlushTrayDamage(void);
 
 /** Resize a tray.
  * @param tp The tray to resize containing the new requested size information.